@@ -0,0 +1,193 @@
+/* Benchmark of lookup latency under adversarial keys.
+
+   Usage: bench/adversarial [N]...
+
+   For each N (by default 20000), fills a chained table with N
+   keys of each set below, then times 200000 single hash_find()
+   calls on random keys of the set, half of them hits, and reports
+   the mean insertion time and the 50th, 99th and 99.9th
+   percentiles of lookup latency.  The sets are:
+
+     random    random ints.
+
+     crafted   keys whose hash_int() values all land in bucket 0 of
+               an unseeded table of up to 2**13 buckets, which is
+               what an attacker who knows hash.c can compute.  The
+               table's seed scatters them.
+
+     lowbits   keys hashed by a function that ignores their low 12
+               bits, so N keys share a handful of hash values.  No
+               seed can help; the trees on long chains bound the
+               cost instead.
+
+   Each latency includes a clock read, some tens of ns. */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "hash.h"
+#include "random.h"
+
+#define GOLDEN_64 0x9e3779b97f4a7c15ull
+#define CRAFT_BITS 13
+#define LOOKUP_CNT 200000
+
+/* Hash function for the set in use: hash_int() of the key, or of
+   the key without its low bits. */
+static int ignored_bits;
+
+static unsigned
+elem_hash (const struct hash_elem *e, void *aux __attribute__ ((unused)))
+{
+  return hash_int (e->value >> ignored_bits);
+}
+
+static bool
+elem_less (const struct hash_elem *a, const struct hash_elem *b,
+           void *aux __attribute__ ((unused)))
+{
+  return a->value < b->value;
+}
+
+static bool
+elem_eq (const struct hash_elem *a, const struct hash_elem *b,
+         void *aux __attribute__ ((unused)))
+{
+  return a->value == b->value;
+}
+
+static int
+compare_doubles (const void *a_, const void *b_)
+{
+  double a = *(const double *) a_, b = *(const double *) b_;
+
+  return (a > b) - (a < b);
+}
+
+/* Fills KEYS with 2 * N distinct keys of set KIND, 0 to 2, for
+   N to go into the table and N to miss. */
+static void
+make_keys (int kind, int *keys, size_t n)
+{
+  size_t i = 0;
+  int k = 0;
+
+  random_init (42);
+  while (i < 2 * n)
+    {
+      if (kind == 0)
+        {
+          /* hash_int() is a bijection, so these are distinct. */
+          keys[i] = (int) hash_int ((int) i);
+          i++;
+        }
+      else if (kind == 1)
+        {
+          /* Bucket 0 of 2**CRAFT_BITS, as bucket_index() would
+             pick it without a seed. */
+          if ((hash_int (k) * GOLDEN_64) >> (64 - CRAFT_BITS) == 0)
+            keys[i++] = k;
+          k++;
+        }
+      else
+        {
+          keys[i] = (int) i;
+          i++;
+        }
+    }
+
+  /* Mix hits and misses. */
+  for (i = 2 * n; i > 1; i--)
+    {
+      size_t j = random_bounded (i);
+      int tmp = keys[i - 1];
+      keys[i - 1] = keys[j];
+      keys[j] = tmp;
+    }
+}
+
+int
+main (int argc, char **argv)
+{
+  static const size_t defaults[] = { 20000 };
+  static const char *kinds[] = { "random", "crafted", "lowbits" };
+  size_t size_cnt, s;
+  size_t *sizes = bench_sizes (argc - 1, argv + 1, defaults,
+                               sizeof defaults / sizeof *defaults,
+                               &size_cnt);
+  double *lat = malloc (sizeof *lat * LOOKUP_CNT);
+
+  if (lat == NULL)
+    {
+      fprintf (stderr, "out of memory\n");
+      return EXIT_FAILURE;
+    }
+
+  printf ("%8s %8s %12s %9s %9s %9s %6s\n", "n", "keys", "insert ns",
+          "p50 ns", "p99 ns", "p99.9 ns", "trees");
+  for (s = 0; s < size_cnt; s++)
+    {
+      size_t n = sizes[s];
+      int *keys = malloc (sizeof *keys * 2 * n);
+      struct hash_elem *elems = malloc (sizeof *elems * n);
+      int kind;
+
+      if (keys == NULL || elems == NULL)
+        {
+          printf ("%8zu out of memory\n", n);
+          free (keys);
+          free (elems);
+          continue;
+        }
+
+      for (kind = 0; kind < 3; kind++)
+        {
+          struct hash h;
+          struct hash_stats st;
+          double start, insert;
+          size_t i, found = 0;
+
+          make_keys (kind, keys, n);
+          ignored_bits = kind == 2 ? 12 : 0;
+          if (!hash_init (&h, elem_hash, elem_less, NULL))
+            abort ();
+          hash_set_eq (&h, elem_eq);
+
+          start = bench_now ();
+          for (i = 0; i < n; i++)
+            {
+              elems[i].value = keys[i];
+              if (hash_insert (&h, &elems[i]) != NULL)
+                abort ();
+            }
+          insert = bench_now () - start;
+
+          for (i = 0; i < LOOKUP_CNT; i++)
+            {
+              struct hash_elem key;
+
+              key.value = keys[random_bounded (2 * n)];
+              start = bench_now ();
+              found += hash_find (&h, &key) != NULL;
+              lat[i] = bench_now () - start;
+            }
+          qsort (lat, LOOKUP_CNT, sizeof *lat, compare_doubles);
+          hash_stats (&h, &st);
+
+          printf ("%8zu %8s %12.0f %9.0f %9.0f %9.0f %6zu\n", n, kinds[kind],
+                  insert / n * 1e9, lat[LOOKUP_CNT / 2] * 1e9,
+                  lat[LOOKUP_CNT * 99 / 100] * 1e9,
+                  lat[LOOKUP_CNT * 999 / 1000] * 1e9, st.tree_cnt);
+          if (found == 0)
+            abort ();
+          hash_destroy (&h, NULL);
+        }
+      free (elems);
+      free (keys);
+    }
+  free (lat);
+  free (sizes);
+  return 0;
+}
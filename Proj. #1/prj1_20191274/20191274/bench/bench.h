@@ -0,0 +1,59 @@
+#ifndef __MYLIB_BENCH_H
+#define __MYLIB_BENCH_H
+
+/* Helpers shared by the benchmark drivers in this directory.
+
+   Each driver is a standalone program that links against the
+   library sources, built with optimization by `make bench'.  The
+   drivers seed random.h with a fixed seed, so two runs work on
+   the same keys; the timings still depend on the machine. */
+
+#include <malloc.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* Returns the time of the monotonic clock, in seconds. */
+static inline double
+bench_now (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Returns the number of bytes currently allocated from malloc(),
+   so that the difference between two calls is what the code in
+   between kept allocated, malloc()'s own chunk headers
+   included. */
+static inline size_t
+bench_heap_bytes (void)
+{
+  return mallinfo2 ().uordblks + mallinfo2 ().hblkhd;
+}
+
+/* Returns the N arguments in ARGV as sizes, or, if N is 0, the
+   DEFAULT_CNT sizes in DEFAULTS.  Stores the number returned in
+   *CNT.  Exits if memory is exhausted. */
+static inline size_t *
+bench_sizes (int n, char **argv, const size_t *defaults, size_t default_cnt,
+             size_t *cnt)
+{
+  size_t *sizes;
+  size_t i;
+
+  *cnt = n > 0 ? (size_t) n : default_cnt;
+  sizes = malloc (sizeof *sizes * *cnt);
+  if (sizes == NULL)
+    {
+      fprintf (stderr, "out of memory\n");
+      exit (EXIT_FAILURE);
+    }
+  for (i = 0; i < *cnt; i++)
+    sizes[i] = n > 0 ? strtoull (argv[i], NULL, 0) : defaults[i];
+  return sizes;
+}
+
+#endif /* bench/bench.h */
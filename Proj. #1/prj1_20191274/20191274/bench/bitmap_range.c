@@ -0,0 +1,115 @@
+/* Benchmark of bitmap range operations.
+
+   Usage: bench/bitmap_range [N]...
+
+   For each range size N (by default 1, 7, 64, 1000, 1e5 and 1e7),
+   sets and clears ranges of N bits at random offsets in a map of
+   2N + 64 bits, about BIT_BUDGET bits in all, once with
+   bitmap_set_multiple() and once with a loop of bitmap_set(), and
+   checks that both leave the same bits.  Reports ns per bit for
+   each.
+
+   Then it times bitmap_create(), bitmap_set_all (true) and
+   bitmap_set_all (false) on a map of BIG_BITS bits; the first
+   set_all includes the page faults of touching fresh memory. */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "bitmap.h"
+#include "random.h"
+
+#define BIT_BUDGET 20000000
+#define BIG_BITS 1000000000
+
+/* Sets and clears ranges of N bits at random offsets in B, with
+   bitmap_set_multiple() if MULTIPLE or bit by bit otherwise.
+   Returns the seconds taken per bit. */
+static double
+fill (struct bitmap *b, size_t n, bool multiple)
+{
+  size_t rounds = BIT_BUDGET / n > 0 ? BIT_BUDGET / n : 1;
+  size_t span = bitmap_size (b) - n + 1, r, i;
+  double start;
+
+  random_init (42);
+  start = bench_now ();
+  for (r = 0; r < rounds; r++)
+    {
+      size_t ofs = random_bounded (span);
+      bool value = r % 2 == 0;
+
+      if (multiple)
+        bitmap_set_multiple (b, ofs, n, value);
+      else
+        for (i = 0; i < n; i++)
+          bitmap_set (b, ofs + i, value);
+    }
+  return (bench_now () - start) / ((double) rounds * n);
+}
+
+int
+main (int argc, char **argv)
+{
+  static const size_t defaults[] = { 1, 7, 64, 1000, 100000, 10000000 };
+  size_t size_cnt, s;
+  size_t *sizes = bench_sizes (argc - 1, argv + 1, defaults,
+                               sizeof defaults / sizeof *defaults,
+                               &size_cnt);
+  struct bitmap *big;
+  double start;
+
+  printf ("%10s %14s %12s %8s\n", "range bits", "multiple ns", "loop ns",
+          "speedup");
+  for (s = 0; s < size_cnt; s++)
+    {
+      size_t n = sizes[s], i;
+      struct bitmap *a = bitmap_create (2 * n + 64);
+      struct bitmap *b = bitmap_create (2 * n + 64);
+      double multiple, loop;
+
+      if (a == NULL || b == NULL)
+        {
+          printf ("%10zu out of memory\n", n);
+          if (a != NULL)
+            bitmap_destroy (a);
+          if (b != NULL)
+            bitmap_destroy (b);
+          continue;
+        }
+
+      multiple = fill (a, n, true);
+      loop = fill (b, n, false);
+      for (i = 0; i < bitmap_size (a); i++)
+        if (bitmap_test (a, i) != bitmap_test (b, i))
+          abort ();
+
+      printf ("%10zu %14.3f %12.3f %7.1fx\n", n, multiple * 1e9, loop * 1e9,
+              loop / multiple);
+      bitmap_destroy (a);
+      bitmap_destroy (b);
+    }
+
+  start = bench_now ();
+  big = bitmap_create (BIG_BITS);
+  if (big == NULL)
+    {
+      printf ("%d-bit map: out of memory\n", BIG_BITS);
+      free (sizes);
+      return 0;
+    }
+  printf ("\n%d-bit map:\n", BIG_BITS);
+  printf ("  bitmap_create    %10.3f ms\n", (bench_now () - start) * 1e3);
+  start = bench_now ();
+  bitmap_set_all (big, true);
+  printf ("  set_all true     %10.3f ms\n", (bench_now () - start) * 1e3);
+  start = bench_now ();
+  bitmap_set_all (big, false);
+  printf ("  set_all false    %10.3f ms\n", (bench_now () - start) * 1e3);
+  if (bitmap_count (big, 0, BIG_BITS, true) != 0)
+    abort ();
+  bitmap_destroy (big);
+  free (sizes);
+  return 0;
+}
@@ -0,0 +1,134 @@
+/* Benchmark of a chained table's Bloom filter (hash_set_bloom())
+   on lookups that mostly miss.
+
+   Usage: bench/bloom_miss [N]...
+
+   For each N (by default 1e6), fills a chained table with N
+   scattered keys and makes 4N hash_find_key() calls whose keys
+   miss 90%, 50% and 0% of the time, once without the filter and
+   once with it.  Reports millions of lookups per second for each
+   and the filter's false positive rate, the share of the misses it
+   let through, from hash_stats(). */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "hash.h"
+#include "random.h"
+
+static unsigned
+elem_hash (const struct hash_elem *e, void *aux __attribute__ ((unused)))
+{
+  return hash_int (e->value);
+}
+
+static bool
+elem_less (const struct hash_elem *a, const struct hash_elem *b,
+           void *aux __attribute__ ((unused)))
+{
+  return a->value < b->value;
+}
+
+static bool
+elem_eq (const struct hash_elem *a, const struct hash_elem *b,
+         void *aux __attribute__ ((unused)))
+{
+  return a->value == b->value;
+}
+
+static bool
+key_eq (const struct hash_elem *e, const void *key,
+        void *aux __attribute__ ((unused)))
+{
+  return e->value == *(const int *) key;
+}
+
+int
+main (int argc, char **argv)
+{
+  static const size_t defaults[] = { 1000000 };
+  static const int miss_pcts[] = { 90, 50, 0 };
+  size_t size_cnt, s;
+  size_t *sizes = bench_sizes (argc - 1, argv + 1, defaults,
+                               sizeof defaults / sizeof *defaults,
+                               &size_cnt);
+
+  printf ("%10s %7s %10s %10s %9s\n", "n", "misses", "plain M/s",
+          "bloom M/s", "false +");
+  for (s = 0; s < size_cnt; s++)
+    {
+      size_t n = sizes[s], lookup_cnt = 4 * n;
+      struct hash_elem *elems = malloc (sizeof *elems * n);
+      int *keys = malloc (sizeof *keys * lookup_cnt);
+      size_t p;
+
+      if (elems == NULL || keys == NULL)
+        {
+          printf ("%10zu out of memory\n", n);
+          free (elems);
+          free (keys);
+          continue;
+        }
+
+      for (p = 0; p < sizeof miss_pcts / sizeof *miss_pcts; p++)
+        {
+          double mops[2];
+          struct hash_stats st;
+          size_t found[2], i;
+          int bloom;
+
+          /* hash_int() is a bijection: keys 0 to N-1 are in the
+             table and keys N and up miss. */
+          random_init (42);
+          for (i = 0; i < lookup_cnt; i++)
+            keys[i] = (int) hash_int ((int) (random_bounded (100)
+                                             < (unsigned) miss_pcts[p]
+                                             ? n + random_bounded (n)
+                                             : random_bounded (n)));
+
+          for (bloom = 0; bloom < 2; bloom++)
+            {
+              struct hash h;
+              double start;
+
+              if (!hash_init (&h, elem_hash, elem_less, NULL))
+                abort ();
+              hash_set_eq (&h, elem_eq);
+              for (i = 0; i < n; i++)
+                {
+                  elems[i].value = (int) hash_int ((int) i);
+                  if (hash_insert (&h, &elems[i]) != NULL)
+                    abort ();
+                }
+              if (bloom && !hash_set_bloom (&h, true))
+                abort ();
+              hash_set_stats (&h, true);
+
+              found[bloom] = 0;
+              start = bench_now ();
+              for (i = 0; i < lookup_cnt; i++)
+                found[bloom] += hash_find_key (&h, &keys[i],
+                                               hash_int (keys[i]),
+                                               key_eq) != NULL;
+              mops[bloom] = lookup_cnt / (bench_now () - start) / 1e6;
+              hash_stats (&h, &st);
+              hash_destroy (&h, NULL);
+            }
+
+          if (found[0] != found[1])
+            abort ();
+          printf ("%10zu %6d%% %10.1f %10.1f", n, miss_pcts[p], mops[0],
+                  mops[1]);
+          if (found[1] < lookup_cnt)
+            printf (" %8.1f%%\n",
+                    100.0 * st.bloom_fp_cnt / (lookup_cnt - found[1]));
+          else
+            printf (" %9s\n", "-");
+        }
+      free (elems);
+      free (keys);
+    }
+  free (sizes);
+  return 0;
+}
@@ -0,0 +1,130 @@
+/* Benchmark of a chained table's memory per entry and lookup
+   throughput.
+
+   Usage: bench/chain_memory [N]...
+
+   For each N (by default 1e5, 1e6 and 4e6), upserts N distinct
+   scattered keys into a chained table whose elements come from a
+   slab, as testlib's "hash_insert" does, then makes 2N
+   hash_find_key() calls, half of them hits.  Reports the heap
+   bytes per key (bucket array, elements and slab chunks together)
+   and the part of it taken by the bucket array, with millions of
+   upserts and finds per second. */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "hash.h"
+#include "random.h"
+#include "slab.h"
+
+#define SLAB_CHUNK_OBJS 1024    /* As in testlib. */
+
+static unsigned
+elem_hash (const struct hash_elem *e, void *aux __attribute__ ((unused)))
+{
+  return hash_int (e->value);
+}
+
+static bool
+elem_less (const struct hash_elem *a, const struct hash_elem *b,
+           void *aux __attribute__ ((unused)))
+{
+  return a->value < b->value;
+}
+
+static bool
+elem_eq (const struct hash_elem *a, const struct hash_elem *b,
+         void *aux __attribute__ ((unused)))
+{
+  return a->value == b->value;
+}
+
+static bool
+key_eq (const struct hash_elem *e, const void *key,
+        void *aux __attribute__ ((unused)))
+{
+  return e->value == *(const int *) key;
+}
+
+static struct slab slab;
+
+static struct hash_elem *
+make_elem (const void *key, void *aux __attribute__ ((unused)))
+{
+  struct hash_elem *e = slab_alloc (&slab);
+
+  if (e != NULL)
+    e->value = *(const int *) key;
+  return e;
+}
+
+int
+main (int argc, char **argv)
+{
+  static const size_t defaults[] = { 100000, 1000000, 4000000 };
+  size_t size_cnt, s;
+  size_t *sizes = bench_sizes (argc - 1, argv + 1, defaults,
+                               sizeof defaults / sizeof *defaults,
+                               &size_cnt);
+
+  printf ("%10s %10s %12s %12s %10s\n", "n", "bytes/key", "bucket part",
+          "upsert M/s", "find M/s");
+  for (s = 0; s < size_cnt; s++)
+    {
+      size_t n = sizes[s], heap, i, found = 0;
+      int *keys = malloc (sizeof *keys * 2 * n);
+      struct hash h;
+      struct hash_stats st;
+      double start, upsert, find;
+
+      if (keys == NULL)
+        {
+          printf ("%10zu out of memory\n", n);
+          continue;
+        }
+
+      /* hash_int() is a bijection, so the keys are distinct; the
+         first N go in and the rest miss. */
+      for (i = 0; i < 2 * n; i++)
+        keys[i] = (int) hash_int ((int) i);
+
+      heap = bench_heap_bytes ();
+      if (!hash_init (&h, elem_hash, elem_less, NULL))
+        abort ();
+      hash_set_eq (&h, elem_eq);
+      slab_init (&slab, sizeof (struct hash_elem), SLAB_CHUNK_OBJS);
+
+      start = bench_now ();
+      for (i = 0; i < n; i++)
+        if (hash_upsert (&h, &keys[i], hash_int (keys[i]), key_eq, make_elem,
+                         NULL) == NULL)
+          abort ();
+      upsert = bench_now () - start;
+      heap = bench_heap_bytes () - heap;
+      hash_stats (&h, &st);
+
+      random_init (42);
+      start = bench_now ();
+      for (i = 0; i < 2 * n; i++)
+        {
+          int *key = &keys[i % 2 == 0 ? random_bounded (n)
+                           : n + random_bounded (n)];
+
+          found += hash_find_key (&h, key, hash_int (*key), key_eq) != NULL;
+        }
+      find = bench_now () - start;
+      if (found != n)
+        abort ();
+
+      printf ("%10zu %10.1f %12.1f %12.1f %10.1f\n", n, (double) heap / n,
+              (double) st.bucket_cnt * sizeof (struct hash_elem *) / n,
+              n / upsert / 1e6, 2 * n / find / 1e6);
+      hash_destroy (&h, NULL);
+      slab_release (&slab);
+      free (keys);
+    }
+  free (sizes);
+  return 0;
+}
@@ -0,0 +1,240 @@
+/* Benchmark of struct chash against one struct hash behind a
+   mutex, from one thread to many.
+
+   Usage: bench/chash_threads [THREADS]...
+
+   Prefills each table with half of 2**20 keys, then runs 4e6
+   operations split evenly among THREADS threads (by default 1, 2,
+   4 and 8), each on random keys, in three mixes:
+
+     read-heavy    90% finds,  5% inserts,  5% deletes
+     mixed         50% finds, 25% inserts, 25% deletes
+     write-heavy   10% finds, 45% inserts, 45% deletes
+
+   Reports millions of operations per second.  Scaling needs as
+   many processors as threads; with fewer, the threads only take
+   turns, and the difference left is the cost of locking. */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "bench.h"
+#include "chash.h"
+#include "hash.h"
+
+#define KEY_CNT (1 << 20)
+#define OP_CNT 4000000
+
+static unsigned
+elem_hash (const struct hash_elem *e, void *aux __attribute__ ((unused)))
+{
+  return hash_int (e->value);
+}
+
+static bool
+elem_less (const struct hash_elem *a, const struct hash_elem *b,
+           void *aux __attribute__ ((unused)))
+{
+  return a->value < b->value;
+}
+
+static bool
+elem_eq (const struct hash_elem *a, const struct hash_elem *b,
+         void *aux __attribute__ ((unused)))
+{
+  return a->value == b->value;
+}
+
+/* The table under test: a chash, or a hash and its lock. */
+static bool use_chash;
+static struct chash chash;
+static struct hash locked_hash;
+static pthread_mutex_t hash_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static struct hash_elem *
+do_insert (struct hash_elem *e)
+{
+  struct hash_elem *old;
+
+  if (use_chash)
+    return chash_insert (&chash, e);
+  pthread_mutex_lock (&hash_lock);
+  old = hash_insert (&locked_hash, e);
+  pthread_mutex_unlock (&hash_lock);
+  return old;
+}
+
+static struct hash_elem *
+do_find (struct hash_elem *key)
+{
+  struct hash_elem *found;
+
+  if (use_chash)
+    return chash_find (&chash, key);
+  pthread_mutex_lock (&hash_lock);
+  found = hash_find (&locked_hash, key);
+  pthread_mutex_unlock (&hash_lock);
+  return found;
+}
+
+static struct hash_elem *
+do_delete (struct hash_elem *key)
+{
+  struct hash_elem *found;
+
+  if (use_chash)
+    return chash_delete (&chash, key);
+  pthread_mutex_lock (&hash_lock);
+  found = hash_delete (&locked_hash, key);
+  pthread_mutex_unlock (&hash_lock);
+  return found;
+}
+
+/* One thread's share of the work.  Elements are never freed
+   during a run, so deleting another thread's element is safe;
+   every insert takes a fresh element from `pool'. */
+struct worker
+  {
+    pthread_t thread;
+    uint64_t seed;              /* Private generator state. */
+    size_t op_cnt;              /* Operations to run. */
+    unsigned find_pct;          /* Percentage of finds. */
+    struct hash_elem *pool;     /* `op_cnt' elements to insert. */
+    size_t hit_cnt;             /* Finds that found an element. */
+  };
+
+/* Returns the next value of the linear congruential generator in
+   *STATE.  random.h's generator is global, so each thread uses
+   its own. */
+static uint64_t
+next_random (uint64_t *state)
+{
+  *state = *state * 6364136223846793005ull + 1442695040888963407ull;
+  return *state >> 16;
+}
+
+static void *
+run_worker (void *w_)
+{
+  struct worker *w = w_;
+  size_t i, used = 0;
+
+  for (i = 0; i < w->op_cnt; i++)
+    {
+      uint64_t r = next_random (&w->seed);
+      unsigned pct = r % 100;
+      struct hash_elem key;
+
+      key.value = (int) ((r >> 8) % KEY_CNT);
+      if (pct < w->find_pct)
+        w->hit_cnt += do_find (&key) != NULL;
+      else if ((pct - w->find_pct) % 2 == 0)
+        {
+          struct hash_elem *e = &w->pool[used];
+
+          e->value = key.value;
+          if (do_insert (e) == NULL)
+            used++;
+        }
+      else
+        do_delete (&key);
+    }
+  return NULL;
+}
+
+int
+main (int argc, char **argv)
+{
+  static const size_t defaults[] = { 1, 2, 4, 8 };
+  static const struct
+    {
+      const char *name;
+      unsigned find_pct;
+    }
+  mixes[] = { { "read-heavy", 90 }, { "mixed", 50 }, { "write-heavy", 10 } };
+  size_t thread_cnt, m, t, i;
+  size_t *threads = bench_sizes (argc - 1, argv + 1, defaults,
+                                 sizeof defaults / sizeof *defaults,
+                                 &thread_cnt);
+  struct hash_elem *prefill = malloc (sizeof *prefill * KEY_CNT / 2);
+
+  if (prefill == NULL)
+    {
+      fprintf (stderr, "out of memory\n");
+      return EXIT_FAILURE;
+    }
+
+  printf ("%ld online processors, Mops/s\n", sysconf (_SC_NPROCESSORS_ONLN));
+  printf ("%-12s %8s %10s %10s\n", "mix", "threads", "chash", "hash+lock");
+  for (m = 0; m < sizeof mixes / sizeof *mixes; m++)
+    for (t = 0; t < thread_cnt; t++)
+      {
+        size_t n = threads[t] > 0 ? threads[t] : 1;
+        double mops[2];
+
+        for (use_chash = false; ; use_chash = true)
+          {
+            struct worker *workers = calloc (n, sizeof *workers);
+            double start;
+
+            if (workers == NULL)
+              abort ();
+            if (use_chash)
+              {
+                if (!chash_init (&chash, 0, elem_hash, elem_less, NULL))
+                  abort ();
+                chash_set_eq (&chash, elem_eq);
+              }
+            else
+              {
+                if (!hash_init (&locked_hash, elem_hash, elem_less, NULL))
+                  abort ();
+                hash_set_eq (&locked_hash, elem_eq);
+              }
+            for (i = 0; i < KEY_CNT / 2; i++)
+              {
+                prefill[i].value = (int) (2 * i);
+                do_insert (&prefill[i]);
+              }
+
+            for (i = 0; i < n; i++)
+              {
+                workers[i].seed = 42 + i;
+                workers[i].op_cnt = OP_CNT / n;
+                workers[i].find_pct = mixes[m].find_pct;
+                workers[i].pool = malloc (sizeof *workers[i].pool
+                                          * workers[i].op_cnt);
+                if (workers[i].pool == NULL)
+                  abort ();
+              }
+
+            start = bench_now ();
+            for (i = 0; i < n; i++)
+              if (pthread_create (&workers[i].thread, NULL, run_worker,
+                                  &workers[i]) != 0)
+                abort ();
+            for (i = 0; i < n; i++)
+              pthread_join (workers[i].thread, NULL);
+            mops[use_chash] = OP_CNT / (bench_now () - start) / 1e6;
+
+            if (use_chash)
+              chash_destroy (&chash, NULL);
+            else
+              hash_destroy (&locked_hash, NULL);
+            for (i = 0; i < n; i++)
+              free (workers[i].pool);
+            free (workers);
+            if (use_chash)
+              break;
+          }
+        printf ("%-12s %8zu %10.2f %10.2f\n", mixes[m].name, n,
+                mops[1], mops[0]);
+      }
+
+  free (prefill);
+  free (threads);
+  return 0;
+}
@@ -0,0 +1,142 @@
+/* Benchmark of lookups on long chains, with and without an
+   equality function (hash_set_eq()).
+
+   Usage: bench/eq_lookup [LEN]...
+
+   For each chain length LEN (by default 2, 4, 8, 16 and 64),
+   fills a chained table with 2**18 elements whose string keys
+   share a long prefix, in groups of LEN keys that have the same
+   hash value.  Every group thus lands in one bucket, and the
+   cached hashes cannot tell its members apart, so each lookup
+   compares keys along the group's chain.  The table is then
+   searched for every key, in random order, once with only the
+   `less' function and once with an equality function installed.
+   Reports ns per lookup and key comparisons per lookup.
+
+   Chains longer than 16 elements are indexed by a tree, which
+   orders them with `less' either way. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "hash.h"
+#include "random.h"
+
+#define ELEM_CNT (1 << 18)
+
+/* Element with a string key.  Keys in the same group of LEN
+   hash alike: `elem.value' holds the group number. */
+struct item
+  {
+    struct hash_elem elem;
+    char key[32];
+  };
+
+#define hash_to_item(HASH_ELEM)                                 \
+        ((const struct item *) ((const char *) (HASH_ELEM)      \
+                                - offsetof (struct item, elem)))
+
+static unsigned long compare_cnt;
+
+static unsigned
+item_hash (const struct hash_elem *e, void *aux __attribute__ ((unused)))
+{
+  return hash_int (e->value);
+}
+
+static bool
+item_less (const struct hash_elem *a, const struct hash_elem *b,
+           void *aux __attribute__ ((unused)))
+{
+  compare_cnt++;
+  return strcmp (hash_to_item (a)->key,
+                 hash_to_item (b)->key) < 0;
+}
+
+static bool
+item_eq (const struct hash_elem *a, const struct hash_elem *b,
+         void *aux __attribute__ ((unused)))
+{
+  compare_cnt++;
+  return !strcmp (hash_to_item (a)->key,
+                  hash_to_item (b)->key);
+}
+
+int
+main (int argc, char **argv)
+{
+  static const size_t defaults[] = { 2, 4, 8, 16, 64 };
+  size_t len_cnt, l, i;
+  size_t *lens = bench_sizes (argc - 1, argv + 1, defaults,
+                              sizeof defaults / sizeof *defaults, &len_cnt);
+  struct item *items = malloc (sizeof *items * ELEM_CNT);
+  struct item *keys = malloc (sizeof *keys * ELEM_CNT);
+
+  if (items == NULL || keys == NULL)
+    {
+      fprintf (stderr, "out of memory\n");
+      return EXIT_FAILURE;
+    }
+
+  printf ("%6s %10s %12s %10s %12s\n",
+          "len", "less ns", "less cmps", "eq ns", "eq cmps");
+  for (l = 0; l < len_cnt; l++)
+    {
+      size_t len = lens[l] > 0 ? lens[l] : 1;
+      double ns[2], cmps[2];
+      int use_eq;
+
+      random_init (42);
+      for (i = 0; i < ELEM_CNT; i++)
+        {
+          items[i].elem.value = (int) (i / len);
+          snprintf (items[i].key, sizeof items[i].key,
+                    "some/common/prefix/%010zu", i);
+        }
+      for (i = 0; i < ELEM_CNT; i++)
+        keys[i] = items[i];
+      for (i = ELEM_CNT; i > 1; i--)
+        {
+          size_t j = random_bounded (i);
+          struct item tmp = keys[i - 1];
+          keys[i - 1] = keys[j];
+          keys[j] = tmp;
+        }
+
+      for (use_eq = 0; use_eq < 2; use_eq++)
+        {
+          struct hash h;
+          size_t found = 0;
+          double start;
+
+          if (!hash_init (&h, item_hash, item_less, NULL))
+            abort ();
+          if (use_eq)
+            hash_set_eq (&h, item_eq);
+          for (i = 0; i < ELEM_CNT; i++)
+            if (hash_insert (&h, &items[i].elem) != NULL)
+              abort ();
+
+          compare_cnt = 0;
+          start = bench_now ();
+          for (i = 0; i < ELEM_CNT; i++)
+            found += hash_find (&h, &keys[i].elem) != NULL;
+          ns[use_eq] = (bench_now () - start) / ELEM_CNT * 1e9;
+          cmps[use_eq] = (double) compare_cnt / ELEM_CNT;
+          if (found != ELEM_CNT)
+            abort ();
+          hash_destroy (&h, NULL);
+        }
+      printf ("%6zu %10.1f %12.2f %10.1f %12.2f\n",
+              len, ns[0], cmps[0], ns[1], cmps[1]);
+    }
+
+  free (keys);
+  free (items);
+  free (lens);
+  return 0;
+}
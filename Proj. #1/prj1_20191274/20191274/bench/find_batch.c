@@ -0,0 +1,125 @@
+/* Benchmark of hash_find_batch() against a loop of hash_find().
+
+   Usage: bench/find_batch [N]...
+
+   For each N (by default 4e6), fills a chained and an
+   open-addressing table with N scattered keys, then looks up N
+   random keys, half of them hits, once with a hash_find() per key
+   and once with hash_find_batch() over arrays of BATCH keys.
+   Reports millions of lookups per second for each. */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "hash.h"
+#include "random.h"
+
+#define BATCH 1024
+
+static unsigned
+elem_hash (const struct hash_elem *e, void *aux __attribute__ ((unused)))
+{
+  return hash_int (e->value);
+}
+
+static bool
+elem_less (const struct hash_elem *a, const struct hash_elem *b,
+           void *aux __attribute__ ((unused)))
+{
+  return a->value < b->value;
+}
+
+static bool
+elem_eq (const struct hash_elem *a, const struct hash_elem *b,
+         void *aux __attribute__ ((unused)))
+{
+  return a->value == b->value;
+}
+
+int
+main (int argc, char **argv)
+{
+  static const size_t defaults[] = { 4000000 };
+  static const char *kinds[] = { "chain", "open" };
+  size_t size_cnt, s;
+  size_t *sizes = bench_sizes (argc - 1, argv + 1, defaults,
+                               sizeof defaults / sizeof *defaults,
+                               &size_cnt);
+
+  printf ("%10s %6s %10s %10s %8s\n", "n", "table", "find M/s", "batch M/s",
+          "speedup");
+  for (s = 0; s < size_cnt; s++)
+    {
+      size_t n = sizes[s];
+      struct hash_elem *elems = malloc (sizeof *elems * n);
+      struct hash_elem *probes = malloc (sizeof *probes * n);
+      struct hash_elem **keys = malloc (sizeof *keys * n);
+      struct hash_elem **out = malloc (sizeof *out * BATCH);
+      size_t i;
+      int kind;
+
+      if (elems == NULL || probes == NULL || keys == NULL || out == NULL)
+        {
+          printf ("%10zu out of memory\n", n);
+          free (elems);
+          free (probes);
+          free (keys);
+          free (out);
+          continue;
+        }
+
+      /* hash_int() is a bijection: keys 0 to N-1 are in the table
+         and keys N to 2N-1 miss. */
+      random_init (42);
+      for (i = 0; i < n; i++)
+        {
+          elems[i].value = (int) hash_int ((int) i);
+          probes[i].value = (int) hash_int ((int) random_bounded (2 * n));
+          keys[i] = &probes[i];
+        }
+
+      for (kind = 0; kind < 2; kind++)
+        {
+          struct hash h;
+          size_t found = 0, batch_found = 0, j;
+          double start, loop, batch;
+
+          if (!(kind == 1 ? hash_init_open (&h, elem_hash, elem_less, NULL)
+                : hash_init (&h, elem_hash, elem_less, NULL)))
+            abort ();
+          hash_set_eq (&h, elem_eq);
+          for (i = 0; i < n; i++)
+            if (hash_insert (&h, &elems[i]) != NULL)
+              abort ();
+
+          start = bench_now ();
+          for (i = 0; i < n; i++)
+            found += hash_find (&h, keys[i]) != NULL;
+          loop = bench_now () - start;
+
+          start = bench_now ();
+          for (i = 0; i < n; i += BATCH)
+            {
+              size_t cnt = n - i < BATCH ? n - i : BATCH;
+
+              hash_find_batch (&h, keys + i, cnt, out);
+              for (j = 0; j < cnt; j++)
+                batch_found += out[j] != NULL;
+            }
+          batch = bench_now () - start;
+
+          if (found != batch_found)
+            abort ();
+          printf ("%10zu %6s %10.1f %10.1f %7.2fx\n", n, kinds[kind],
+                  n / loop / 1e6, n / batch / 1e6, loop / batch);
+          hash_destroy (&h, NULL);
+        }
+      free (elems);
+      free (probes);
+      free (keys);
+      free (out);
+    }
+  free (sizes);
+  return 0;
+}
@@ -0,0 +1,174 @@
+/* Speed and quality of the integer hash functions.
+
+   Usage: bench/hash_quality
+
+   For each function, reports:
+
+     - ns/hash: time per call over 1e8 sequential keys.
+
+     - Avalanche: for every input bit and output bit, how often
+       flipping the input bit flips the output bit, over random
+       keys.  An ideal hash flips every output bit half the time.
+       Shown are the worst and the mean deviation from 0.5.
+
+     - Chi-square: 2**15 keys spread over 2**12 buckets, both by
+       the low bits of the hash (HASH & (BUCKET_CNT - 1), as
+       hash.c used to) and by Fibonacci hashing (as hash.c's
+       bucket_index() does now), for sequential keys, keys 64
+       apart, and random keys.  Shown is chi-square divided by its
+       degrees of freedom, which is near 1 for a uniform spread;
+       well above 1 means crowded buckets.
+
+   "fnv" is hash.c's old hash_int(), FNV-1 over the key's bytes. */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "bench.h"
+#include "hash.h"
+#include "random.h"
+
+#define GOLDEN_64 0x9e3779b97f4a7c15ull
+
+#define BUCKET_BITS 12
+#define BUCKET_CNT (1 << BUCKET_BITS)
+#define KEY_CNT (BUCKET_CNT * 8)
+
+static unsigned
+fnv (int i)
+{
+  const unsigned char *b = (const unsigned char *) &i;
+  unsigned hash = 2166136261u;
+  size_t k;
+
+  for (k = 0; k < sizeof i; k++)
+    hash = (hash * 16777619u) ^ b[k];
+  return hash;
+}
+
+static unsigned
+bytes (int i)
+{
+  return hash_bytes (&i, sizeof i);
+}
+
+static unsigned
+u64 (int i)
+{
+  return hash_u64 ((uint64_t) (unsigned) i);
+}
+
+struct function
+  {
+    const char *name;
+    unsigned (*hash) (int);
+  };
+
+static const struct function functions[] =
+  {
+    { "fnv", fnv },
+    { "hash_int", hash_int },
+    { "hash_int_2", hash_int_2 },
+    { "hash_u64", u64 },
+    { "hash_bytes", bytes },
+  };
+
+/* Returns the Ith key of KIND: 0 for sequential, 1 for 64
+   apart, 2 for random. */
+static int
+make_key (int kind, int i)
+{
+  if (kind == 0)
+    return i;
+  if (kind == 1)
+    return i * 64;
+  return (int) random_u64 ();
+}
+
+/* Returns chi-square over degrees of freedom for KEY_CNT keys of
+   KIND hashed by HASH into BUCKET_CNT buckets, chosen by
+   Fibonacci hashing if FIBONACCI is nonzero or by the low bits of
+   the hash otherwise. */
+static double
+chi_square (unsigned (*hash) (int), int kind, int fibonacci)
+{
+  static unsigned cnt[BUCKET_CNT];
+  double expected = (double) KEY_CNT / BUCKET_CNT, chi = 0.0;
+  int i;
+
+  for (i = 0; i < BUCKET_CNT; i++)
+    cnt[i] = 0;
+  random_init (42);
+  for (i = 0; i < KEY_CNT; i++)
+    {
+      unsigned h = hash (make_key (kind, i));
+      cnt[fibonacci ? (h * GOLDEN_64) >> (64 - BUCKET_BITS)
+          : h & (BUCKET_CNT - 1)]++;
+    }
+  for (i = 0; i < BUCKET_CNT; i++)
+    chi += (cnt[i] - expected) * (cnt[i] - expected) / expected;
+  return chi / (BUCKET_CNT - 1);
+}
+
+int
+main (void)
+{
+  static const char *kinds[] = { "seq", "stride64", "random" };
+  size_t f;
+
+  printf ("%-11s %8s %9s %9s", "", "ns/hash", "aval max", "aval avg");
+  for (f = 0; f < 3; f++)
+    printf (" %8s %8s", kinds[f], "");
+  printf ("\n%-11s %8s %9s %9s", "", "", "", "");
+  for (f = 0; f < 3; f++)
+    printf (" %8s %8s", "mask", "fib");
+  printf ("\n");
+
+  for (f = 0; f < sizeof functions / sizeof *functions; f++)
+    {
+      unsigned (*hash) (int) = functions[f].hash;
+      static unsigned flips[32][32];
+      volatile unsigned sink = 0;
+      double start, ns, worst = 0.0, sum = 0.0;
+      const int trials = 20000;
+      int i, in, out, kind;
+
+      start = bench_now ();
+      for (i = 0; i < 100000000; i++)
+        sink += hash (i);
+      ns = (bench_now () - start) / 1e8 * 1e9;
+
+      random_init (42);
+      for (in = 0; in < 32; in++)
+        for (out = 0; out < 32; out++)
+          flips[in][out] = 0;
+      for (i = 0; i < trials; i++)
+        {
+          int key = (int) random_u64 ();
+          unsigned h = hash (key);
+
+          for (in = 0; in < 32; in++)
+            {
+              unsigned d = h ^ hash (key ^ (int) (1u << in));
+              for (out = 0; out < 32; out++)
+                flips[in][out] += (d >> out) & 1;
+            }
+        }
+      for (in = 0; in < 32; in++)
+        for (out = 0; out < 32; out++)
+          {
+            double bias = fabs ((double) flips[in][out] / trials - 0.5);
+            if (bias > worst)
+              worst = bias;
+            sum += bias;
+          }
+
+      printf ("%-11s %8.2f %9.3f %9.3f", functions[f].name, ns, worst,
+              sum / (32 * 32));
+      for (kind = 0; kind < 3; kind++)
+        printf (" %8.2f %8.2f", chi_square (hash, kind, 0),
+                chi_square (hash, kind, 1));
+      printf ("\n");
+    }
+  return 0;
+}
@@ -0,0 +1,148 @@
+/* Benchmark of the flat int set (intset.h) against struct hash,
+   as testlib uses them for "create hashtable".
+
+   Usage: bench/int_set_memory [N]...
+
+   For each N (by default 1e5, 7e5, 1e6 and 4e6), inserts N
+   distinct keys into a chained table and an open-addressing table
+   whose elements come from a slab, as in testlib, and into a flat
+   int set.  Then it looks up 2N keys, half of them misses.  Reports
+   millions of insertions and finds per second, and the heap bytes
+   per key, elements and slab chunks included.
+
+   A flat set's bytes per key depend on where N falls between its
+   doublings: 4 bytes per slot at 7/16 to 7/8 load, so 4.6 to 9.1
+   bytes per key. */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "hash.h"
+#include "intset.h"
+#include "slab.h"
+
+#define SLAB_CHUNK_OBJS 1024    /* As in testlib. */
+
+static unsigned
+elem_hash (const struct hash_elem *e, void *aux __attribute__ ((unused)))
+{
+  return hash_int (e->value);
+}
+
+static bool
+elem_less (const struct hash_elem *a, const struct hash_elem *b,
+           void *aux __attribute__ ((unused)))
+{
+  return a->value < b->value;
+}
+
+static bool
+elem_eq (const struct hash_elem *a, const struct hash_elem *b,
+         void *aux __attribute__ ((unused)))
+{
+  return a->value == b->value;
+}
+
+/* Returns the Ith key.  hash_int() is a bijection, so keys are
+   distinct and scattered; keys N and up are the misses. */
+static int
+key (size_t i)
+{
+  return (int) hash_int ((int) i);
+}
+
+int
+main (int argc, char **argv)
+{
+  static const size_t defaults[] = { 100000, 700000, 1000000, 4000000 };
+  static const char *kinds[] = { "chain", "open", "flat" };
+  size_t size_cnt, s;
+  size_t *sizes = bench_sizes (argc - 1, argv + 1, defaults,
+                               sizeof defaults / sizeof *defaults,
+                               &size_cnt);
+
+  printf ("%10s %6s %12s %10s %10s\n", "n", "table", "insert M/s",
+          "find M/s", "bytes/key");
+  for (s = 0; s < size_cnt; s++)
+    {
+      size_t n = sizes[s];
+      int kind;
+
+      for (kind = 0; kind < 3; kind++)
+        {
+          struct hash h;
+          struct slab slab;
+          struct int_set set;
+          size_t heap, i, found = 0;
+          double start, insert, find;
+
+          heap = bench_heap_bytes ();
+          if (kind == 2)
+            {
+              if (!int_set_init (&set))
+                abort ();
+            }
+          else
+            {
+              if (!(kind == 1 ? hash_init_open (&h, elem_hash, elem_less, NULL)
+                    : hash_init (&h, elem_hash, elem_less, NULL)))
+                abort ();
+              hash_set_eq (&h, elem_eq);
+              slab_init (&slab, sizeof (struct hash_elem), SLAB_CHUNK_OBJS);
+            }
+
+          start = bench_now ();
+          for (i = 0; i < n; i++)
+            if (kind == 2)
+              {
+                if (!int_set_insert (&set, key (i)))
+                  abort ();
+              }
+            else
+              {
+                struct hash_elem *e = slab_alloc (&slab);
+
+                if (e == NULL)
+                  abort ();
+                e->value = key (i);
+                if (hash_insert (&h, e) != NULL)
+                  abort ();
+              }
+          insert = bench_now () - start;
+          heap = bench_heap_bytes () - heap;
+
+          start = bench_now ();
+          for (i = 0; i < 2 * n; i++)
+            {
+              /* Alternate hits and misses. */
+              size_t k = i % 2 == 0 ? i / 2 : n + i / 2;
+
+              if (kind == 2)
+                found += int_set_contains (&set, key (k));
+              else
+                {
+                  struct hash_elem probe;
+
+                  probe.value = key (k);
+                  found += hash_find (&h, &probe) != NULL;
+                }
+            }
+          find = bench_now () - start;
+          if (found != n)
+            abort ();
+
+          printf ("%10zu %6s %12.1f %10.1f %10.1f\n", n, kinds[kind],
+                  n / insert / 1e6, 2 * n / find / 1e6, (double) heap / n);
+          if (kind == 2)
+            int_set_destroy (&set);
+          else
+            {
+              hash_destroy (&h, NULL);
+              slab_release (&slab);
+            }
+        }
+    }
+  free (sizes);
+  return 0;
+}
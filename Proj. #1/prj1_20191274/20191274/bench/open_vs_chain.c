@@ -0,0 +1,142 @@
+/* Benchmark of open addressing (hash_init_open()) against
+   chaining (hash_init()).
+
+   Usage: bench/open_vs_chain [N]...
+
+   For each N (by default 1e5, 1e6 and 4e6), inserts N distinct
+   int keys, in random order, into a table of each kind, then looks
+   up every key in another random order and looks up N keys that
+   are not in the table.  Reports ns per operation, and the bytes
+   of table the heap grew by per entry, not counting the 16-byte
+   elements themselves, which both kinds of table share. */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "hash.h"
+#include "random.h"
+
+static unsigned
+elem_hash (const struct hash_elem *e, void *aux __attribute__ ((unused)))
+{
+  return hash_int (e->value);
+}
+
+static bool
+elem_less (const struct hash_elem *a, const struct hash_elem *b,
+           void *aux __attribute__ ((unused)))
+{
+  return a->value < b->value;
+}
+
+static bool
+elem_eq (const struct hash_elem *a, const struct hash_elem *b,
+         void *aux __attribute__ ((unused)))
+{
+  return a->value == b->value;
+}
+
+/* Shuffles the N ints in A. */
+static void
+shuffle (int *a, size_t n)
+{
+  size_t i;
+
+  for (i = n; i > 1; i--)
+    {
+      size_t j = random_bounded (i);
+      int tmp = a[i - 1];
+      a[i - 1] = a[j];
+      a[j] = tmp;
+    }
+}
+
+int
+main (int argc, char **argv)
+{
+  static const size_t defaults[] = { 100000, 1000000, 4000000 };
+  size_t size_cnt, s;
+  size_t *sizes = bench_sizes (argc - 1, argv + 1, defaults,
+                               sizeof defaults / sizeof *defaults,
+                               &size_cnt);
+
+  printf ("%10s %6s %10s %10s %10s %10s\n",
+          "n", "table", "insert", "find hit", "find miss", "B/entry");
+  for (s = 0; s < size_cnt; s++)
+    {
+      size_t n = sizes[s], i;
+      struct hash_elem *elems = malloc (sizeof *elems * n);
+      int *keys = malloc (sizeof *keys * n);
+      int open;
+
+      if (elems == NULL || keys == NULL)
+        {
+          printf ("%10zu out of memory\n", n);
+          free (elems);
+          free (keys);
+          continue;
+        }
+
+      /* Even keys go in; odd keys are the misses. */
+      random_init (42);
+      for (i = 0; i < n; i++)
+        keys[i] = (int) (2 * i);
+      shuffle (keys, n);
+
+      for (open = 0; open < 2; open++)
+        {
+          struct hash h;
+          size_t heap, found = 0;
+          double start, insert, hit, miss;
+
+          heap = bench_heap_bytes ();
+          if (!(open ? hash_init_open (&h, elem_hash, elem_less, NULL)
+                : hash_init (&h, elem_hash, elem_less, NULL)))
+            abort ();
+          hash_set_eq (&h, elem_eq);
+
+          start = bench_now ();
+          for (i = 0; i < n; i++)
+            {
+              elems[i].value = keys[i];
+              if (hash_insert (&h, &elems[i]) != NULL)
+                abort ();
+            }
+          insert = bench_now () - start;
+          heap = bench_heap_bytes () - heap;
+
+          shuffle (keys, n);
+          start = bench_now ();
+          for (i = 0; i < n; i++)
+            {
+              struct hash_elem key;
+
+              key.value = keys[i];
+              found += hash_find (&h, &key) != NULL;
+            }
+          hit = bench_now () - start;
+
+          start = bench_now ();
+          for (i = 0; i < n; i++)
+            {
+              struct hash_elem key;
+
+              key.value = keys[i] + 1;
+              found += hash_find (&h, &key) != NULL;
+            }
+          miss = bench_now () - start;
+          if (found != n)
+            abort ();
+
+          printf ("%10zu %6s %9.1fns %9.1fns %9.1fns %10.1f\n", n,
+                  open ? "open" : "chain", insert / n * 1e9, hit / n * 1e9,
+                  miss / n * 1e9, (double) heap / n);
+          hash_destroy (&h, NULL);
+        }
+      free (keys);
+      free (elems);
+    }
+  free (sizes);
+  return 0;
+}
@@ -0,0 +1,108 @@
+/* Benchmark of list_radix_sort() against list_sort().
+
+   Usage: bench/radix_sort [-r] [N]...
+
+   For each N (by default 1e5, 1e6 and 1e7), builds a list of N
+   struct list_items with random DATA, linked in random order so
+   that following the list jumps around memory, and times
+   list_sort() and then list_radix_sort() on it, reshuffling in
+   between.  Both results are checked.  -r skips list_sort(),
+   which takes minutes from 1e7 elements up.
+
+   list_radix_sort() needs 32 bytes of scratch per element on top
+   of the items themselves, and falls back on list_sort() without
+   them, so an N too large for memory times list_sort() twice. */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "list.h"
+#include "random.h"
+
+static bool
+item_less (const struct list_elem *a, const struct list_elem *b,
+           void *aux __attribute__ ((unused)))
+{
+  return list_entry (a, struct list_item, elem)->data
+         < list_entry (b, struct list_item, elem)->data;
+}
+
+/* Returns true if LIST is in nondecreasing order of DATA. */
+static bool
+is_sorted (struct list *list)
+{
+  struct list_elem *e;
+
+  for (e = list_begin (list); e != list_end (list); e = list_next (e))
+    if (list_next (e) != list_end (list)
+        && item_less (list_next (e), e, NULL))
+      return false;
+  return true;
+}
+
+int
+main (int argc, char **argv)
+{
+  static const size_t defaults[] = { 100000, 1000000, 10000000 };
+  bool radix_only = argc > 1 && !strcmp (argv[1], "-r");
+  size_t size_cnt, s;
+  size_t *sizes;
+
+  if (radix_only)
+    {
+      argc--;
+      argv++;
+    }
+  sizes = bench_sizes (argc - 1, argv + 1, defaults,
+                       sizeof defaults / sizeof *defaults, &size_cnt);
+
+  printf ("%12s %12s %12s %8s\n", "n", "list_sort", "radix_sort", "speedup");
+  for (s = 0; s < size_cnt; s++)
+    {
+      size_t n = sizes[s], i;
+      struct list_item *items = malloc (sizeof *items * n);
+      struct list list;
+      double start, merge = 0.0, radix;
+
+      if (items == NULL)
+        {
+          printf ("%12zu out of memory\n", n);
+          continue;
+        }
+      random_init (42);
+      list_init (&list);
+      for (i = 0; i < n; i++)
+        {
+          items[i].data = (int) random_u64 ();
+          list_push_back (&list, &items[i].elem);
+        }
+
+      if (!radix_only)
+        {
+          list_shuffle (&list);
+          start = bench_now ();
+          list_sort (&list, item_less, NULL);
+          merge = bench_now () - start;
+          if (!is_sorted (&list))
+            abort ();
+        }
+
+      list_shuffle (&list);
+      start = bench_now ();
+      list_radix_sort (&list);
+      radix = bench_now () - start;
+      if (!is_sorted (&list))
+        abort ();
+
+      if (radix_only)
+        printf ("%12zu %12s %11.3fs\n", n, "-", radix);
+      else
+        printf ("%12zu %11.3fs %11.3fs %7.1fx\n", n, merge, radix,
+                merge / radix);
+      free (items);
+    }
+  free (sizes);
+  return 0;
+}
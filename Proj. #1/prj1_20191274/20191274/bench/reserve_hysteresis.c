@@ -0,0 +1,163 @@
+/* Benchmark of resize hysteresis and hash_reserve().
+
+   Usage: bench/reserve_hysteresis [N]...
+
+   First, fills a table of each kind with 8192 elements, a power of
+   two, then deletes and reinserts one element 2000000 times, so
+   that the element count crosses the boundary at every step.
+   Reports seconds and the number of resizes; with hysteresis the
+   table should not resize at all.
+
+   Then, for each N (by default 1e7), inserts N distinct keys into
+   an empty table of each kind, once as is and once after
+   hash_reserve (N), and reports seconds and resizes for each. */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "hash.h"
+
+#define OSC_ELEMS 8192
+#define OSC_PAIRS 2000000
+
+static unsigned
+elem_hash (const struct hash_elem *e, void *aux __attribute__ ((unused)))
+{
+  return hash_int (e->value);
+}
+
+static bool
+elem_less (const struct hash_elem *a, const struct hash_elem *b,
+           void *aux __attribute__ ((unused)))
+{
+  return a->value < b->value;
+}
+
+static bool
+elem_eq (const struct hash_elem *a, const struct hash_elem *b,
+         void *aux __attribute__ ((unused)))
+{
+  return a->value == b->value;
+}
+
+static const char *kinds[] = { "chain", "open" };
+
+/* Initializes H as a table of KIND, 0 for chained or 1 for open
+   addressing. */
+static void
+init (struct hash *h, int kind)
+{
+  if (!(kind == 1 ? hash_init_open (h, elem_hash, elem_less, NULL)
+        : hash_init (h, elem_hash, elem_less, NULL)))
+    abort ();
+  hash_set_eq (h, elem_eq);
+}
+
+/* Returns the number of resizes H has gone through. */
+static size_t
+rehash_cnt (struct hash *h)
+{
+  struct hash_stats st;
+
+  hash_stats (h, &st);
+  return st.rehash_cnt;
+}
+
+int
+main (int argc, char **argv)
+{
+  static const size_t defaults[] = { 10000000 };
+  size_t size_cnt, s;
+  size_t *sizes = bench_sizes (argc - 1, argv + 1, defaults,
+                               sizeof defaults / sizeof *defaults,
+                               &size_cnt);
+  struct hash_elem *elems = malloc (sizeof *elems * OSC_ELEMS);
+  int kind;
+
+  if (elems == NULL)
+    {
+      fprintf (stderr, "out of memory\n");
+      return EXIT_FAILURE;
+    }
+
+  printf ("%d delete+insert pairs at %d elements\n", OSC_PAIRS, OSC_ELEMS);
+  printf ("%6s %10s %8s\n", "table", "seconds", "resizes");
+  for (kind = 0; kind < 2; kind++)
+    {
+      struct hash h;
+      size_t i, before;
+      double start;
+
+      init (&h, kind);
+      for (i = 0; i < OSC_ELEMS; i++)
+        {
+          elems[i].value = (int) i;
+          hash_insert (&h, &elems[i]);
+        }
+      before = rehash_cnt (&h);
+
+      start = bench_now ();
+      for (i = 0; i < OSC_PAIRS; i++)
+        {
+          struct hash_elem *e = &elems[i % OSC_ELEMS];
+
+          if (hash_delete (&h, e) != e || hash_insert (&h, e) != NULL)
+            abort ();
+        }
+      start = bench_now () - start;
+
+      printf ("%6s %10.3f %8zu\n", kinds[kind], start,
+              rehash_cnt (&h) - before);
+      hash_destroy (&h, NULL);
+    }
+  free (elems);
+
+  printf ("\n%10s %6s %10s %8s %10s %8s\n", "n", "table", "plain s",
+          "resizes", "reserve s", "resizes");
+  for (s = 0; s < size_cnt; s++)
+    {
+      size_t n = sizes[s];
+
+      elems = malloc (sizeof *elems * n);
+      if (elems == NULL)
+        {
+          printf ("%10zu out of memory\n", n);
+          continue;
+        }
+
+      for (kind = 0; kind < 2; kind++)
+        {
+          double secs[2];
+          size_t resizes[2];
+          int reserve;
+
+          for (reserve = 0; reserve < 2; reserve++)
+            {
+              struct hash h;
+              size_t i;
+              double start;
+
+              init (&h, kind);
+              start = bench_now ();
+              if (reserve && !hash_reserve (&h, n))
+                abort ();
+              for (i = 0; i < n; i++)
+                {
+                  elems[i].value = (int) i;
+                  if (hash_insert (&h, &elems[i]) != NULL)
+                    abort ();
+                }
+              secs[reserve] = bench_now () - start;
+              resizes[reserve] = rehash_cnt (&h);
+              hash_destroy (&h, NULL);
+            }
+
+          printf ("%10zu %6s %10.3f %8zu %10.3f %8zu\n", n, kinds[kind],
+                  secs[0], resizes[0], secs[1], resizes[1]);
+        }
+      free (elems);
+    }
+  free (sizes);
+  return 0;
+}
@@ -0,0 +1,108 @@
+/* Benchmark of list push/pop churn with list_items from malloc()
+   and from a slab.
+
+   Usage: bench/slab_churn [LIVE [OPS]]
+
+   Fills a list to LIVE (by default 1e5) items, then performs OPS
+   (by default 2e7) random pushes and pops at either end, keeping
+   the list near LIVE items, the way testlib's push and pop
+   commands do.  Each pushed item is allocated, and each popped
+   item freed, first with malloc() and free() and then with
+   slab_alloc() and slab_free(), as testlib does.  Reports the time
+   per operation, and the heap bytes per live item at the end. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "list.h"
+#include "random.h"
+#include "slab.h"
+
+static struct slab item_slab;
+
+static struct list_item *
+alloc_item (int use_slab)
+{
+  struct list_item *item = (use_slab ? slab_alloc (&item_slab)
+                            : malloc (sizeof *item));
+
+  if (item == NULL)
+    {
+      fprintf (stderr, "out of memory\n");
+      exit (EXIT_FAILURE);
+    }
+  return item;
+}
+
+static void
+free_item (int use_slab, struct list_item *item)
+{
+  if (use_slab)
+    slab_free (&item_slab, item);
+  else
+    free (item);
+}
+
+int
+main (int argc, char **argv)
+{
+  size_t live = argc > 1 ? strtoull (argv[1], NULL, 0) : 100000;
+  size_t ops = argc > 2 ? strtoull (argv[2], NULL, 0) : 20000000;
+  int use_slab;
+
+  printf ("%zu live items, %zu operations\n", live, ops);
+  printf ("%8s %10s %14s\n", "nodes", "ns/op", "bytes/item");
+  for (use_slab = 0; use_slab < 2; use_slab++)
+    {
+      size_t heap_before, heap_after, size = 0, i;
+      struct list list;
+      double start, elapsed;
+
+      random_init (42);
+      slab_init (&item_slab, sizeof (struct list_item), 1024);
+      list_init (&list);
+      heap_before = bench_heap_bytes ();
+      for (i = 0; i < live; i++, size++)
+        list_push_back (&list, &alloc_item (use_slab)->elem);
+
+      start = bench_now ();
+      for (i = 0; i < ops; i++)
+        {
+          uint64_t r = random_u64 ();
+
+          /* Push or pop with equal odds, at a random end, but pop
+             more often when the list is above LIVE. */
+          if ((r & 0xffff) < (size < live ? 0x8800u : 0x7800u))
+            {
+              struct list_item *item = alloc_item (use_slab);
+
+              item->data = (int) i;
+              if (r & 0x10000)
+                list_push_front (&list, &item->elem);
+              else
+                list_push_back (&list, &item->elem);
+              size++;
+            }
+          else if (size > 0)
+            {
+              struct list_elem *e = (r & 0x10000 ? list_pop_front (&list)
+                                     : list_pop_back (&list));
+
+              free_item (use_slab, list_entry (e, struct list_item, elem));
+              size--;
+            }
+        }
+      elapsed = bench_now () - start;
+      heap_after = bench_heap_bytes ();
+
+      printf ("%8s %10.1f %14.1f\n", use_slab ? "slab" : "malloc",
+              elapsed / ops * 1e9,
+              (double) (heap_after - heap_before) / size);
+
+      while (!list_empty (&list))
+        free_item (use_slab, list_entry (list_pop_front (&list),
+                                         struct list_item, elem));
+      slab_release (&item_slab);
+    }
+  return 0;
+}
@@ -0,0 +1,195 @@
+/* Benchmark of loading a table from a snapshot (hash_load(),
+   int_set_load()) against rebuilding it by replaying commands.
+
+   Usage: bench/snapshot_load [N]...
+
+   For each N (by default 1e5, 1e6 and 4e6), builds a script of N
+   "hash_insert hash0 KEY" lines over distinct random keys and a
+   snapshot of the same keys, then fills an empty table of each
+   kind both ways: by parsing the script and inserting each key
+   as testlib does, and by loading the snapshot.  Reports ms for
+   each and their ratio.  The snapshot is read from the page
+   cache, as it would be right after being saved. */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "bench.h"
+#include "hash.h"
+#include "intset.h"
+#include "random.h"
+
+#define SNAP_FILE "bench-snapshot_load.snap"
+
+static unsigned
+elem_hash (const struct hash_elem *e, void *aux __attribute__ ((unused)))
+{
+  return hash_int (e->value);
+}
+
+static bool
+elem_less (const struct hash_elem *a, const struct hash_elem *b,
+           void *aux __attribute__ ((unused)))
+{
+  return a->value < b->value;
+}
+
+static bool
+elem_eq (const struct hash_elem *a, const struct hash_elem *b,
+         void *aux __attribute__ ((unused)))
+{
+  return a->value == b->value;
+}
+
+static bool
+key_eq (const struct hash_elem *e, const void *key,
+        void *aux __attribute__ ((unused)))
+{
+  return e->value == *(const int *) key;
+}
+
+/* Elements handed out by make_elem(), one after another. */
+static struct hash_elem *pool;
+static size_t pool_used;
+
+static struct hash_elem *
+make_elem (const void *key, void *aux __attribute__ ((unused)))
+{
+  struct hash_elem *e = &pool[pool_used++];
+
+  e->value = *(const int *) key;
+  return e;
+}
+
+/* Kinds of table. */
+enum kind { CHAIN, OPEN, INT_SET, KIND_CNT };
+static const char *kind_names[KIND_CNT] = { "chain", "open", "intset" };
+
+/* Fills an empty table of KIND with the keys in SCRIPT, one
+   "hash_insert hash0 KEY" line each, parsing each line as testlib
+   does, if REPLAY, or from SNAP_FILE otherwise.  Returns the
+   seconds taken and stores the table's size in *SIZE. */
+static double
+fill (enum kind kind, bool replay, const char *script, size_t *size)
+{
+  struct hash h;
+  struct int_set s;
+  double start;
+
+  pool_used = 0;
+  if (kind == INT_SET)
+    {
+      if (!int_set_init (&s))
+        abort ();
+    }
+  else
+    {
+      if (!(kind == OPEN ? hash_init_open (&h, elem_hash, elem_less, NULL)
+            : hash_init (&h, elem_hash, elem_less, NULL)))
+        abort ();
+      hash_set_eq (&h, elem_eq);
+    }
+
+  start = bench_now ();
+  if (replay)
+    {
+      const char *p = script;
+
+      /* Skip the command and the table name, as testlib's
+         parsing() splits them off, and convert the key.  (sscanf()
+         would measure the rest of the script on every call.) */
+      while (*p != '\0')
+        {
+          char *end;
+          int key;
+
+          p = strchr (strchr (p, ' ') + 1, ' ') + 1;
+          key = (int) strtol (p, &end, 10);
+          p = end + 1;
+          if (kind == INT_SET)
+            {
+              if (!int_set_insert (&s, key))
+                abort ();
+            }
+          else if (hash_upsert (&h, &key, hash_int (key), key_eq, make_elem,
+                                NULL) == NULL)
+            abort ();
+        }
+    }
+  else if (!(kind == INT_SET ? int_set_load (&s, SNAP_FILE)
+             : hash_load (&h, SNAP_FILE, make_elem)))
+    abort ();
+  start = bench_now () - start;
+
+  if (kind == INT_SET)
+    {
+      *size = int_set_size (&s);
+      int_set_destroy (&s);
+    }
+  else
+    {
+      *size = hash_size (&h);
+      hash_destroy (&h, NULL);
+    }
+  return start;
+}
+
+int
+main (int argc, char **argv)
+{
+  static const size_t defaults[] = { 100000, 1000000, 4000000 };
+  size_t size_cnt, s;
+  size_t *sizes = bench_sizes (argc - 1, argv + 1, defaults,
+                               sizeof defaults / sizeof *defaults,
+                               &size_cnt);
+
+  printf ("%10s %7s %12s %12s %8s\n", "n", "table", "replay ms", "load ms",
+          "speedup");
+  for (s = 0; s < size_cnt; s++)
+    {
+      size_t n = sizes[s], i, len = 0;
+      char *script = malloc (n * 32 + 1);
+      struct int_set keys;
+      int k;
+
+      pool = malloc (sizeof *pool * n);
+      if (script == NULL || pool == NULL || !int_set_init (&keys))
+        {
+          printf ("%10zu out of memory\n", n);
+          free (script);
+          free (pool);
+          continue;
+        }
+
+      /* N distinct keys, written out as a script and saved. */
+      random_init (42);
+      while (int_set_size (&keys) < n)
+        int_set_insert (&keys, (int) random_u64 ());
+      i = 0;
+      while (int_set_next (&keys, &i, &k))
+        len += sprintf (script + len, "hash_insert hash0 %d\n", k);
+      if (!int_set_save (&keys, SNAP_FILE))
+        abort ();
+      int_set_destroy (&keys);
+
+      for (k = 0; k < KIND_CNT; k++)
+        {
+          size_t replay_size, load_size;
+          double replay = fill (k, true, script, &replay_size);
+          double load = fill (k, false, script, &load_size);
+
+          if (replay_size != n || load_size != n)
+            abort ();
+          printf ("%10zu %7s %12.1f %12.1f %7.1fx\n", n, kind_names[k],
+                  replay * 1e3, load * 1e3, replay / load);
+        }
+
+      unlink (SNAP_FILE);
+      free (pool);
+      free (script);
+    }
+  free (sizes);
+  return 0;
+}
@@ -0,0 +1,117 @@
+/* Benchmark of list_sort_parallel() against list_sort(), from one
+   thread to many.
+
+   Usage: bench/sort_parallel [N [THREADS]...]
+
+   Builds a list of N (by default 1e6) struct list_items with
+   random DATA, linked in random order, and sorts the same list
+   with list_sort() and then with list_sort_parallel() at each
+   thread count in THREADS (by default 1, 2, 4 and 8).  Every
+   result is checked against list_sort()'s, element by element,
+   so a difference in stability shows up too.  The comparison
+   looks only at DATA / 16, so that there are plenty of ties.
+
+   Speedup needs as many processors as threads; with fewer, the
+   extra threads only add their merge rounds. */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "bench.h"
+#include "list.h"
+#include "random.h"
+
+static bool
+coarse_less (const struct list_elem *a, const struct list_elem *b,
+             void *aux __attribute__ ((unused)))
+{
+  return list_entry (a, struct list_item, elem)->data / 16
+         < list_entry (b, struct list_item, elem)->data / 16;
+}
+
+/* Links the N items at the indexes in ORDER into LIST. */
+static void
+build (struct list *list, struct list_item *items, const size_t *order,
+       size_t n)
+{
+  size_t i;
+
+  list_init (list);
+  for (i = 0; i < n; i++)
+    list_push_back (list, &items[order[i]].elem);
+}
+
+int
+main (int argc, char **argv)
+{
+  static const size_t defaults[] = { 1, 2, 4, 8 };
+  size_t n = argc > 1 ? strtoull (argv[1], NULL, 0) : 1000000;
+  size_t thread_cnt, t, i;
+  size_t *threads = bench_sizes (argc > 2 ? argc - 2 : 0, argv + 2,
+                                 defaults,
+                                 sizeof defaults / sizeof *defaults,
+                                 &thread_cnt);
+  struct list_item *items = malloc (sizeof *items * n);
+  struct list_elem **expected = malloc (sizeof *expected * n);
+  size_t *order = malloc (sizeof *order * n);
+  struct list list;
+  struct list_elem *e;
+  double start, serial;
+
+  if (items == NULL || expected == NULL || order == NULL)
+    {
+      fprintf (stderr, "out of memory\n");
+      return EXIT_FAILURE;
+    }
+
+  random_init (42);
+  for (i = 0; i < n; i++)
+    {
+      items[i].data = (int) random_bounded (1u << 30);
+      order[i] = i;
+    }
+  for (i = n; i > 1; i--)
+    {
+      size_t j = random_bounded (i), tmp = order[i - 1];
+      order[i - 1] = order[j];
+      order[j] = tmp;
+    }
+
+  build (&list, items, order, n);
+  start = bench_now ();
+  list_sort (&list, coarse_less, NULL);
+  serial = bench_now () - start;
+  for (e = list_begin (&list), i = 0; e != list_end (&list);
+       e = list_next (e), i++)
+    expected[i] = e;
+
+  printf ("n = %zu, %ld online processors\n", n,
+          sysconf (_SC_NPROCESSORS_ONLN));
+  printf ("%8s %10s %8s\n", "threads", "seconds", "speedup");
+  printf ("%8s %9.3fs %7.2fx\n", "serial", serial, 1.0);
+  for (t = 0; t < thread_cnt; t++)
+    {
+      double elapsed;
+
+      build (&list, items, order, n);
+      start = bench_now ();
+      list_sort_parallel (&list, coarse_less, NULL, threads[t]);
+      elapsed = bench_now () - start;
+      for (e = list_begin (&list), i = 0; e != list_end (&list);
+           e = list_next (e), i++)
+        if (e != expected[i])
+          {
+            printf ("%zu threads: order differs from list_sort at %zu\n",
+                    threads[t], i);
+            return EXIT_FAILURE;
+          }
+      printf ("%8zu %9.3fs %7.2fx\n", threads[t], elapsed, serial / elapsed);
+    }
+
+  free (order);
+  free (expected);
+  free (items);
+  free (threads);
+  return 0;
+}
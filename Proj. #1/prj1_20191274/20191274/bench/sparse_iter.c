@@ -0,0 +1,157 @@
+/* Benchmark of walking sparse and dense tables, as testlib's
+   "dumpdata" and "hash_apply" do.
+
+   Usage: bench/sparse_iter [N]...
+
+   For each N (by default 1000), fills a chained and an
+   open-addressing table with N keys after hash_reserve() for
+   2000000 elements, so that almost every bucket is empty.  Then
+   it runs ROUNDS rounds, each formatting every element into a
+   buffer through hash_first() and hash_next() and then calling
+   hash_apply() on the table.  It does the same for a dense table
+   of 100000 elements.  Reports microseconds per round. */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "hash.h"
+
+#define RESERVE 2000000
+#define DENSE_ELEMS 100000
+#define ROUNDS 500
+
+static unsigned
+elem_hash (const struct hash_elem *e, void *aux __attribute__ ((unused)))
+{
+  return hash_int (e->value);
+}
+
+static bool
+elem_less (const struct hash_elem *a, const struct hash_elem *b,
+           void *aux __attribute__ ((unused)))
+{
+  return a->value < b->value;
+}
+
+static bool
+elem_eq (const struct hash_elem *a, const struct hash_elem *b,
+         void *aux __attribute__ ((unused)))
+{
+  return a->value == b->value;
+}
+
+/* Sum of squares computed by square(), so that hash_apply() has
+   work to do without changing any key. */
+static unsigned long long sink;
+
+static void
+square (struct hash_elem *e, void *aux __attribute__ ((unused)))
+{
+  sink += (unsigned long long) e->value * e->value;
+}
+
+/* Runs ROUNDS rounds of dumpdata and hash_apply over H, which
+   holds N elements, and returns the seconds taken per round. */
+static double
+walk (struct hash *h, size_t n)
+{
+  char *buf = malloc (n * 12 + 1);
+  double start;
+  int round;
+
+  if (buf == NULL)
+    abort ();
+  start = bench_now ();
+  for (round = 0; round < ROUNDS; round++)
+    {
+      struct hash_iterator i;
+      size_t len = 0;
+
+      hash_first (&i, h);
+      while (hash_next (&i))
+        len += sprintf (buf + len, "%d ", hash_cur (&i)->value);
+      if (len == 0 && n != 0)
+        abort ();
+      hash_apply (h, square);
+    }
+  start = bench_now () - start;
+  free (buf);
+  return start / ROUNDS;
+}
+
+/* Fills H, of KIND 0 for chained or 1 for open addressing, with
+   the N elements in ELEMS, after reserving room for RESERVED. */
+static void
+fill (struct hash *h, int kind, struct hash_elem *elems, size_t n,
+      size_t reserved)
+{
+  size_t i;
+
+  if (!(kind == 1 ? hash_init_open (h, elem_hash, elem_less, NULL)
+        : hash_init (h, elem_hash, elem_less, NULL)))
+    abort ();
+  hash_set_eq (h, elem_eq);
+  if (reserved != 0 && !hash_reserve (h, reserved))
+    abort ();
+  for (i = 0; i < n; i++)
+    {
+      elems[i].value = (int) hash_int ((int) i);
+      if (hash_insert (h, &elems[i]) != NULL)
+        abort ();
+    }
+}
+
+int
+main (int argc, char **argv)
+{
+  static const size_t defaults[] = { 1000 };
+  static const char *kinds[] = { "chain", "open" };
+  size_t size_cnt, s;
+  size_t *sizes = bench_sizes (argc - 1, argv + 1, defaults,
+                               sizeof defaults / sizeof *defaults,
+                               &size_cnt);
+  size_t max = DENSE_ELEMS;
+  struct hash_elem *elems;
+  int kind;
+
+  for (s = 0; s < size_cnt; s++)
+    if (sizes[s] > max)
+      max = sizes[s];
+  elems = malloc (sizeof *elems * max);
+  if (elems == NULL)
+    {
+      fprintf (stderr, "out of memory\n");
+      return EXIT_FAILURE;
+    }
+
+  printf ("%10s %10s %6s %12s\n", "n", "reserved", "table", "us/round");
+  for (s = 0; s < size_cnt; s++)
+    {
+      size_t n = sizes[s];
+
+      for (kind = 0; kind < 2; kind++)
+        {
+          struct hash h;
+
+          fill (&h, kind, elems, n, RESERVE);
+          printf ("%10zu %10d %6s %12.1f\n", n, RESERVE, kinds[kind],
+                  walk (&h, n) * 1e6);
+          hash_destroy (&h, NULL);
+        }
+    }
+  for (kind = 0; kind < 2; kind++)
+    {
+      struct hash h;
+
+      fill (&h, kind, elems, DENSE_ELEMS, 0);
+      printf ("%10d %10s %6s %12.1f\n", DENSE_ELEMS, "-", kinds[kind],
+              walk (&h, DENSE_ELEMS) * 1e6);
+      hash_destroy (&h, NULL);
+    }
+  if (sink == 0)
+    abort ();
+  free (elems);
+  free (sizes);
+  return 0;
+}
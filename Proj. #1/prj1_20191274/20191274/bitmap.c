@@ -4,6 +4,7 @@
 #include "round.h"	// 		#include <round.h>
 #include <stdio.h>
 #include <stdlib.h>	
+#include <string.h>
 
 
 #include "hex_dump.h"	
@@ -150,12 +151,12 @@ bitmap_create (size_t bit_cnt)
   if (b != NULL)
     {
       b->bit_cnt = bit_cnt;
-      b->bits = malloc (byte_cnt (bit_cnt)); /* byte_cnt(bit_cnt) : ش bit_cnt  bit   ϱ  ʿ byte_cnt return. */
+      b->bits = calloc (elem_cnt (bit_cnt), sizeof (elem_type)); /* elem_cnt(bit_cnt) : ش bit_cnt  bit   ϱ  ʿ elem_type  return. */
+      /* calloc() hands back zeroed memory, often fresh pages from
+         the kernel that need no clearing at all, so there is no
+         bitmap_set_all (b, false) here. */
       if (b->bits != NULL || bit_cnt == 0)
-        {
-          bitmap_set_all (b, false);
-          return b;
-        }
+        return b;
       free (b);
     }
   return NULL;
@@ -177,7 +178,7 @@ bitmap_create_in_buf (size_t bit_cnt, void *block, size_t block_size )
 
   b->bit_cnt = bit_cnt;
   b->bits = (elem_type *) (b + 1);
-  bitmap_set_all (b, false);
+  memset (b->bits, 0, byte_cnt (bit_cnt));
   return b;
 }
 /*
@@ -243,8 +244,10 @@ bitmap_mark (struct bitmap *b, size_t bit_idx)  /* ,that is, bit_idx position
 
   /* This is equivalent to `b->bits[idx] |= mask' except that it
      is guaranteed to be atomic on a uniprocessor machine.  See
-     the description of the OR instruction in [IA32-v2b]. */
-  asm ("orl %k1, %k0" : "=m" (b->bits[idx]) : "r" (mask) : "cc");
+     the description of the OR instruction in [IA32-v2b].  The
+     operand size follows elem_type, so all 64 bits of an element
+     are reachable. */
+  asm ("or %1, %0" : "+m" (b->bits[idx]) : "r" (mask) : "cc");
 }
 
 /* Atomically sets the bit numbered BIT_IDX in B to false. */
@@ -257,7 +260,7 @@ bitmap_reset (struct bitmap *b, size_t bit_idx) /* bitmap[bit_idx] : 1 ==>> 0. *
   /* This is equivalent to `b->bits[idx] &= ~mask' except that it
      is guaranteed to be atomic on a uniprocessor machine.  See
      the description of the AND instruction in [IA32-v2a]. */
-  asm ("andl %k1, %k0" : "=m" (b->bits[idx]) : "r" (~mask) : "cc");
+  asm ("and %1, %0" : "+m" (b->bits[idx]) : "r" (~mask) : "cc");
 }
 
 /* Atomically toggles the bit numbered IDX in B;
@@ -272,7 +275,7 @@ bitmap_flip (struct bitmap *b, size_t bit_idx) /* bitmap_flip() : 0 ==>> 1 || 1
   /* This is equivalent to `b->bits[idx] ^= mask' except that it
      is guaranteed to be atomic on a uniprocessor machine.  See
      the description of the XOR instruction in [IA32-v2b]. */
-  asm ("xorl %k1, %k0" : "=m" (b->bits[idx]) : "r" (mask) : "cc");
+  asm ("xor %1, %0" : "+m" (b->bits[idx]) : "r" (mask) : "cc");
 }
 
 /* Returns the value of the bit numbered IDX in B. */
@@ -295,18 +298,46 @@ bitmap_set_all (struct bitmap *b, bool value)
   bitmap_set_multiple (b, 0, bitmap_size (b), value);
 }
 
-/* Sets the CNT bits starting at START in B to VALUE. */
+/* Sets the bits of *E that are set in MASK to VALUE. */
+static inline void
+set_bits (elem_type *e, elem_type mask, bool value)
+{
+  if (value)
+    *e |= mask;
+  else
+    *e &= ~mask;
+}
+
+/* Sets the CNT bits starting at START in B to VALUE.  Works a
+   whole element at a time: the elements at either end of the
+   range, which it may cover only in part, through masks, and all
+   those in between with one memset().  Unlike bitmap_set(), this
+   is not atomic. */
 void /* ,that is, start ~~ start + cnt - 1 Value value Set. */
 bitmap_set_multiple (struct bitmap *b, size_t start, size_t cnt, bool value) 
 {
-  size_t i;
+  size_t first, last;
+  elem_type head_mask, tail_mask;
   
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
   ASSERT (start + cnt <= b->bit_cnt);
 
-  for (i = 0; i < cnt; i++)
-    bitmap_set (b, start + i, value);
+  if (cnt == 0)
+    return;
+  first = elem_idx (start);
+  last = elem_idx (start + cnt - 1);
+  head_mask = (elem_type) -1 << (start % ELEM_BITS);
+  tail_mask = (elem_type) -1 >> (ELEM_BITS - 1 - (start + cnt - 1) % ELEM_BITS);
+  if (first == last)
+    {
+      set_bits (&b->bits[first], head_mask & tail_mask, value);
+      return;
+    }
+  set_bits (&b->bits[first], head_mask, value);
+  memset (&b->bits[first + 1], value ? 0xff : 0,
+          (last - first - 1) * sizeof (elem_type));
+  set_bits (&b->bits[last], tail_mask, value);
 }
 
 /* Returns the number of bits in B between START and START + CNT,
@@ -395,6 +426,39 @@ bitmap_scan (const struct bitmap *b, size_t start, size_t cnt, bool value)
   return BITMAP_ERROR;
 }
 
+/* Returns the index of the first bit in B at or after START that
+   is set to VALUE, or BITMAP_ERROR if there is none.  Unlike
+   bitmap_scan(), looks at a whole element at a time, so a long
+   run of bits set to !VALUE is skipped quickly. */
+size_t
+bitmap_next (const struct bitmap *b, size_t start, bool value)
+{
+  elem_type flip = value ? 0 : (elem_type) -1;
+  elem_type bits;
+  size_t idx;
+
+  ASSERT (b != NULL);
+  ASSERT (start <= b->bit_cnt);
+
+  if (start == b->bit_cnt)
+    return BITMAP_ERROR;
+
+  idx = elem_idx (start);
+  bits = (b->bits[idx] ^ flip) & ((elem_type) -1 << (start % ELEM_BITS));
+  for (;;)
+    {
+      if (bits != 0)
+        {
+          /* Bits past the end of B may hold anything. */
+          size_t bit_idx = idx * ELEM_BITS + __builtin_ctzl (bits);
+          return bit_idx < b->bit_cnt ? bit_idx : BITMAP_ERROR;
+        }
+      if (++idx >= elem_cnt (b->bit_cnt))
+        return BITMAP_ERROR;
+      bits = b->bits[idx] ^ flip;
+    }
+}
+
 /* Finds the first group of CNT consecutive bits in B at or after
    START that are all set to VALUE, flips them all to !VALUE,
    and returns the index of the first bit in the group.
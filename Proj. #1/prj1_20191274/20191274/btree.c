@@ -0,0 +1,752 @@
+/* Ordered map (B+-tree).
+
+See btree.h for basic information. */
+
+#include "btree.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ASSERT(CONDITION) assert(CONDITION)
+
+/* Node capacities.  Every node but the root stays at least half
+   full, which bounds the height of a tree of N elements by about
+   log16(N). */
+#define LEAF_MAX 32                     /* Most elements in a leaf. */
+#define LEAF_MIN (LEAF_MAX / 2)         /* Fewest, except in the root. */
+#define INNER_MAX 32                    /* Most children of an inner node. */
+#define INNER_MIN (INNER_MAX / 2)       /* Fewest, except in the root. */
+
+/* Header shared by leaves and inner nodes. */
+struct btree_node
+  {
+    bool leaf;                  /* Leaf or inner node? */
+    int cnt;                    /* Elements (leaf) or children (inner). */
+  };
+
+/* Leaf.  The leaves hold all the elements, in order, and form a
+   doubly linked list for iteration. */
+struct btree_leaf
+  {
+    struct btree_node node;
+    struct btree_leaf *prev;            /* Leaf before this one. */
+    struct btree_leaf *next;            /* Leaf after this one. */
+    struct btree_elem *elems[LEAF_MAX]; /* Elements, in order. */
+  };
+
+/* Inner node.  KEYS[I] is the smallest element below
+   CHILDREN[I + 1], so that everything below CHILDREN[I] is less
+   than KEYS[I]. */
+struct btree_inner
+  {
+    struct btree_node node;
+    struct btree_elem *keys[INNER_MAX - 1];     /* `cnt' - 1 separators. */
+    struct btree_node *children[INNER_MAX];     /* `cnt' subtrees. */
+  };
+
+/* Returns N as a leaf. */
+static inline struct btree_leaf *
+as_leaf (struct btree_node *n)
+{
+  ASSERT (n->leaf);
+  return (struct btree_leaf *) n;
+}
+
+/* Returns N as an inner node. */
+static inline struct btree_inner *
+as_inner (struct btree_node *n)
+{
+  ASSERT (!n->leaf);
+  return (struct btree_inner *) n;
+}
+
+/* Returns true if N can take no more elements or children. */
+static inline bool
+node_full (const struct btree_node *n)
+{
+  return n->cnt == (n->leaf ? LEAF_MAX : INNER_MAX);
+}
+
+/* Returns true if N cannot give up an element or child without
+   falling below half full. */
+static inline bool
+node_minimal (const struct btree_node *n)
+{
+  return n->cnt <= (n->leaf ? LEAF_MIN : INNER_MIN);
+}
+
+/* Allocates an empty leaf.  Returns a null pointer if memory is
+   exhausted. */
+static struct btree_leaf *
+new_leaf (void)
+{
+  struct btree_leaf *leaf = malloc (sizeof *leaf);
+  if (leaf != NULL)
+    {
+      leaf->node.leaf = true;
+      leaf->node.cnt = 0;
+      leaf->prev = leaf->next = NULL;
+    }
+  return leaf;
+}
+
+/* Allocates an inner node without children.  Returns a null
+   pointer if memory is exhausted. */
+static struct btree_inner *
+new_inner (void)
+{
+  struct btree_inner *inner = malloc (sizeof *inner);
+  if (inner != NULL)
+    {
+      inner->node.leaf = false;
+      inner->node.cnt = 0;
+    }
+  return inner;
+}
+
+/* Frees N and every node below it. */
+static void
+free_node (struct btree_node *n)
+{
+  if (!n->leaf)
+    {
+      struct btree_inner *inner = as_inner (n);
+      int i;
+
+      for (i = 0; i < inner->node.cnt; i++)
+        free_node (inner->children[i]);
+    }
+  free (n);
+}
+
+/* Returns the index of the first element of LEAF that is not
+   less than E, or LEAF's element count if there is none. */
+static int
+leaf_lower_bound (struct btree *t, struct btree_leaf *leaf,
+                  const struct btree_elem *e)
+{
+  int lo = 0, hi = leaf->node.cnt;
+
+  while (lo < hi)
+    {
+      int mid = (lo + hi) / 2;
+      if (t->less (leaf->elems[mid], e, t->aux))
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+  return lo;
+}
+
+/* Returns the index of the first element of LEAF that is
+   greater than E, or LEAF's element count if there is none. */
+static int
+leaf_upper_bound (struct btree *t, struct btree_leaf *leaf,
+                  const struct btree_elem *e)
+{
+  int lo = 0, hi = leaf->node.cnt;
+
+  while (lo < hi)
+    {
+      int mid = (lo + hi) / 2;
+      if (!t->less (e, leaf->elems[mid], t->aux))
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+  return lo;
+}
+
+/* Returns true if element IDX of LEAF exists and equals E, given
+   that it is the first one not less than E. */
+static inline bool
+leaf_has (struct btree *t, struct btree_leaf *leaf, int idx,
+          const struct btree_elem *e)
+{
+  return idx < leaf->node.cnt && !t->less (e, leaf->elems[idx], t->aux);
+}
+
+/* Returns the index of the child of INNER that E belongs under,
+   which is the number of keys of INNER not greater than E. */
+static int
+child_index (struct btree *t, struct btree_inner *inner,
+             const struct btree_elem *e)
+{
+  int lo = 0, hi = inner->node.cnt - 1;
+
+  while (lo < hi)
+    {
+      int mid = (lo + hi) / 2;
+      if (!t->less (e, inner->keys[mid], t->aux))
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+  return lo;
+}
+
+/* Returns the leaf of nonempty tree T that E belongs in. */
+static struct btree_leaf *
+find_leaf (struct btree *t, const struct btree_elem *e)
+{
+  struct btree_node *n = t->root;
+
+  while (!n->leaf)
+    {
+      struct btree_inner *inner = as_inner (n);
+      n = inner->children[child_index (t, inner, e)];
+    }
+  return as_leaf (n);
+}
+
+/* Splits the full child I of PARENT, which is not full, into two
+   half-full nodes.  Returns false, leaving the tree unchanged, if
+   memory is exhausted. */
+static bool
+split_child (struct btree_inner *parent, int i)
+{
+  struct btree_node *child = parent->children[i];
+  struct btree_node *sibling;
+  struct btree_elem *sep;
+
+  ASSERT (node_full (child));
+  ASSERT (!node_full (&parent->node));
+
+  if (child->leaf)
+    {
+      struct btree_leaf *left = as_leaf (child);
+      struct btree_leaf *right = new_leaf ();
+      if (right == NULL)
+        return false;
+
+      left->node.cnt = LEAF_MAX / 2;
+      right->node.cnt = LEAF_MAX - left->node.cnt;
+      memcpy (right->elems, left->elems + left->node.cnt,
+              sizeof *right->elems * right->node.cnt);
+
+      right->prev = left;
+      right->next = left->next;
+      if (left->next != NULL)
+        left->next->prev = right;
+      left->next = right;
+
+      sep = right->elems[0];
+      sibling = &right->node;
+    }
+  else
+    {
+      struct btree_inner *left = as_inner (child);
+      struct btree_inner *right = new_inner ();
+      if (right == NULL)
+        return false;
+
+      /* The key between the two halves moves up into PARENT. */
+      left->node.cnt = INNER_MAX / 2;
+      right->node.cnt = INNER_MAX - left->node.cnt;
+      memcpy (right->children, left->children + left->node.cnt,
+              sizeof *right->children * right->node.cnt);
+      memcpy (right->keys, left->keys + left->node.cnt,
+              sizeof *right->keys * (right->node.cnt - 1));
+
+      sep = left->keys[left->node.cnt - 1];
+      sibling = &right->node;
+    }
+
+  memmove (parent->keys + i + 1, parent->keys + i,
+           sizeof *parent->keys * (parent->node.cnt - 1 - i));
+  memmove (parent->children + i + 2, parent->children + i + 1,
+           sizeof *parent->children * (parent->node.cnt - 1 - i));
+  parent->keys[i] = sep;
+  parent->children[i + 1] = sibling;
+  parent->node.cnt++;
+  return true;
+}
+
+/* Moves the last element or child of child I - 1 of PARENT to
+   the front of child I. */
+static void
+borrow_from_left (struct btree_inner *parent, int i)
+{
+  struct btree_node *child = parent->children[i];
+  struct btree_node *left = parent->children[i - 1];
+
+  if (child->leaf)
+    {
+      struct btree_leaf *c = as_leaf (child), *l = as_leaf (left);
+
+      memmove (c->elems + 1, c->elems, sizeof *c->elems * c->node.cnt);
+      c->elems[0] = l->elems[--l->node.cnt];
+      c->node.cnt++;
+      parent->keys[i - 1] = c->elems[0];
+    }
+  else
+    {
+      struct btree_inner *c = as_inner (child), *l = as_inner (left);
+
+      memmove (c->keys + 1, c->keys, sizeof *c->keys * (c->node.cnt - 1));
+      memmove (c->children + 1, c->children,
+               sizeof *c->children * c->node.cnt);
+      c->keys[0] = parent->keys[i - 1];
+      c->children[0] = l->children[l->node.cnt - 1];
+      c->node.cnt++;
+      parent->keys[i - 1] = l->keys[l->node.cnt - 2];
+      l->node.cnt--;
+    }
+}
+
+/* Moves the first element or child of child I + 1 of PARENT to
+   the end of child I. */
+static void
+borrow_from_right (struct btree_inner *parent, int i)
+{
+  struct btree_node *child = parent->children[i];
+  struct btree_node *right = parent->children[i + 1];
+
+  if (child->leaf)
+    {
+      struct btree_leaf *c = as_leaf (child), *r = as_leaf (right);
+
+      c->elems[c->node.cnt++] = r->elems[0];
+      memmove (r->elems, r->elems + 1, sizeof *r->elems * --r->node.cnt);
+      parent->keys[i] = r->elems[0];
+    }
+  else
+    {
+      struct btree_inner *c = as_inner (child), *r = as_inner (right);
+
+      c->keys[c->node.cnt - 1] = parent->keys[i];
+      c->children[c->node.cnt] = r->children[0];
+      c->node.cnt++;
+      parent->keys[i] = r->keys[0];
+      memmove (r->keys, r->keys + 1, sizeof *r->keys * (r->node.cnt - 2));
+      memmove (r->children, r->children + 1,
+               sizeof *r->children * (r->node.cnt - 1));
+      r->node.cnt--;
+    }
+}
+
+/* Merges child I + 1 of PARENT into child I, both of them at
+   most half full, and frees it. */
+static void
+merge_children (struct btree_inner *parent, int i)
+{
+  struct btree_node *left = parent->children[i];
+  struct btree_node *right = parent->children[i + 1];
+
+  if (left->leaf)
+    {
+      struct btree_leaf *l = as_leaf (left), *r = as_leaf (right);
+
+      memcpy (l->elems + l->node.cnt, r->elems,
+              sizeof *r->elems * r->node.cnt);
+      l->node.cnt += r->node.cnt;
+      l->next = r->next;
+      if (r->next != NULL)
+        r->next->prev = l;
+    }
+  else
+    {
+      struct btree_inner *l = as_inner (left), *r = as_inner (right);
+
+      /* The separator moves down between the two halves. */
+      l->keys[l->node.cnt - 1] = parent->keys[i];
+      memcpy (l->keys + l->node.cnt, r->keys,
+              sizeof *r->keys * (r->node.cnt - 1));
+      memcpy (l->children + l->node.cnt, r->children,
+              sizeof *r->children * r->node.cnt);
+      l->node.cnt += r->node.cnt;
+    }
+  free (right);
+
+  memmove (parent->keys + i, parent->keys + i + 1,
+           sizeof *parent->keys * (parent->node.cnt - 2 - i));
+  memmove (parent->children + i + 1, parent->children + i + 2,
+           sizeof *parent->children * (parent->node.cnt - 2 - i));
+  parent->node.cnt--;
+}
+
+/* Makes child I of PARENT more than half full, by borrowing from
+   a sibling or merging with one, so that a deletion below it
+   cannot leave it underfull.  Returns the index of the child
+   that now holds what child I held. */
+static int
+fill_child (struct btree_inner *parent, int i)
+{
+  if (i > 0 && !node_minimal (parent->children[i - 1]))
+    borrow_from_left (parent, i);
+  else if (i + 1 < parent->node.cnt
+           && !node_minimal (parent->children[i + 1]))
+    borrow_from_right (parent, i);
+  else if (i + 1 < parent->node.cnt)
+    merge_children (parent, i);
+  else
+    merge_children (parent, --i);
+  return i;
+}
+
+/* Replaces the separator key OLD in T, if there is one, by NEW,
+   the element that now follows OLD. */
+static void
+replace_key (struct btree *t, const struct btree_elem *old,
+             struct btree_elem *new)
+{
+  struct btree_node *n = t->root;
+
+  while (!n->leaf)
+    {
+      struct btree_inner *inner = as_inner (n);
+      int i = child_index (t, inner, old);
+
+      if (i > 0 && inner->keys[i - 1] == old)
+        {
+          inner->keys[i - 1] = new;
+          return;
+        }
+      n = inner->children[i];
+    }
+}
+
+/* Initializes T as an empty B+-tree that orders its elements
+   using LESS, given auxiliary data AUX. */
+void
+btree_init (struct btree *t, btree_less_func *less, void *aux)
+{
+  ASSERT (t != NULL);
+  ASSERT (less != NULL);
+
+  t->root = NULL;
+  t->elem_cnt = 0;
+  t->less = less;
+  t->aux = aux;
+}
+
+/* Removes all the elements from T.  If DESTRUCTOR is non-null,
+   then it is first called for each element, in order, and may
+   deallocate the memory used by the element. */
+void
+btree_clear (struct btree *t, btree_action_func *destructor)
+{
+  ASSERT (t != NULL);
+
+  if (t->root == NULL)
+    return;
+
+  if (destructor != NULL)
+    {
+      struct btree_iterator i;
+      struct btree_elem *e;
+
+      for (e = btree_first (&i, t); e != NULL; e = btree_next (&i))
+        destructor (e, t->aux);
+    }
+
+  free_node (t->root);
+  t->root = NULL;
+  t->elem_cnt = 0;
+}
+
+/* Destroys T, first calling DESTRUCTOR, if non-null, for each
+   element as btree_clear() does. */
+void
+btree_destroy (struct btree *t, btree_action_func *destructor)
+{
+  btree_clear (t, destructor);
+}
+
+/* Inserts NEW into T and returns a null pointer, if no equal
+   element is already in the tree.  If an equal element is
+   already in the tree, returns it without inserting NEW.  If
+   memory is exhausted, returns NEW itself without inserting
+   it. */
+struct btree_elem *
+btree_insert (struct btree *t, struct btree_elem *new)
+{
+  struct btree_node *n;
+  struct btree_leaf *leaf;
+  int idx;
+
+  ASSERT (t != NULL);
+  ASSERT (new != NULL);
+
+  if (t->root == NULL)
+    {
+      leaf = new_leaf ();
+      if (leaf == NULL)
+        return new;
+      t->root = &leaf->node;
+    }
+
+  /* Full nodes are split on the way down, so that there is
+     always room for the separator a split sends up. */
+  if (node_full (t->root))
+    {
+      struct btree_inner *root = new_inner ();
+      if (root == NULL)
+        return new;
+      root->node.cnt = 1;
+      root->children[0] = t->root;
+      if (!split_child (root, 0))
+        {
+          free (root);
+          return new;
+        }
+      t->root = &root->node;
+    }
+
+  n = t->root;
+  while (!n->leaf)
+    {
+      struct btree_inner *inner = as_inner (n);
+      int i = child_index (t, inner, new);
+
+      if (node_full (inner->children[i]))
+        {
+          if (!split_child (inner, i))
+            return new;
+          if (!t->less (new, inner->keys[i], t->aux))
+            i++;
+        }
+      n = inner->children[i];
+    }
+
+  /* NEW cannot become the first element of a leaf other than the
+     leftmost one, since it is not less than the separator that
+     led here, so no separator needs updating. */
+  leaf = as_leaf (n);
+  idx = leaf_lower_bound (t, leaf, new);
+  if (leaf_has (t, leaf, idx, new))
+    return leaf->elems[idx];
+
+  memmove (leaf->elems + idx + 1, leaf->elems + idx,
+           sizeof *leaf->elems * (leaf->node.cnt - idx));
+  leaf->elems[idx] = new;
+  leaf->node.cnt++;
+  t->elem_cnt++;
+  return NULL;
+}
+
+/* Finds and returns an element equal to E in T, or a null
+   pointer if no equal element exists in the tree. */
+struct btree_elem *
+btree_find (struct btree *t, const struct btree_elem *e)
+{
+  struct btree_leaf *leaf;
+  int idx;
+
+  ASSERT (t != NULL);
+
+  if (t->root == NULL)
+    return NULL;
+
+  leaf = find_leaf (t, e);
+  idx = leaf_lower_bound (t, leaf, e);
+  return leaf_has (t, leaf, idx, e) ? leaf->elems[idx] : NULL;
+}
+
+/* Finds, removes, and returns an element equal to E in T.
+   Returns a null pointer if no equal element existed in the
+   tree.  Deallocating the element is up to the caller. */
+struct btree_elem *
+btree_delete (struct btree *t, const struct btree_elem *e)
+{
+  struct btree_node *n;
+  struct btree_leaf *leaf;
+  struct btree_elem *found;
+  int idx;
+
+  ASSERT (t != NULL);
+
+  if (t->root == NULL)
+    return NULL;
+
+  /* Nodes about to fall below half full are refilled on the way
+     down, so that removing an element never needs to go back
+     up. */
+  n = t->root;
+  while (!n->leaf)
+    {
+      struct btree_inner *inner = as_inner (n);
+      int i = child_index (t, inner, e);
+
+      if (node_minimal (inner->children[i]))
+        i = fill_child (inner, i);
+
+      /* A root left with one child gives way to it. */
+      if (n == t->root && inner->node.cnt == 1)
+        {
+          t->root = inner->children[0];
+          free (inner);
+          n = t->root;
+          continue;
+        }
+      n = inner->children[i];
+    }
+
+  leaf = as_leaf (n);
+  idx = leaf_lower_bound (t, leaf, e);
+  if (!leaf_has (t, leaf, idx, e))
+    return NULL;
+
+  found = leaf->elems[idx];
+  memmove (leaf->elems + idx, leaf->elems + idx + 1,
+           sizeof *leaf->elems * (leaf->node.cnt - idx - 1));
+  leaf->node.cnt--;
+  t->elem_cnt--;
+
+  if (leaf->node.cnt == 0)
+    {
+      ASSERT (n == t->root);
+      free (leaf);
+      t->root = NULL;
+    }
+  else if (idx == 0)
+    replace_key (t, found, leaf->elems[0]);
+  return found;
+}
+
+/* Moves I past the end of its leaf, if it is there, to the
+   start of the next one, and returns its element. */
+static struct btree_elem *
+settle (struct btree_iterator *i)
+{
+  if (i->leaf != NULL && i->idx >= i->leaf->node.cnt)
+    {
+      i->leaf = i->leaf->next;
+      i->idx = 0;
+    }
+  return btree_cur (i);
+}
+
+/* Points I at the smallest element of T and returns it, or a
+   null pointer if T is empty. */
+struct btree_elem *
+btree_first (struct btree_iterator *i, struct btree *t)
+{
+  struct btree_node *n;
+
+  ASSERT (i != NULL);
+  ASSERT (t != NULL);
+
+  n = t->root;
+  if (n != NULL)
+    while (!n->leaf)
+      n = as_inner (n)->children[0];
+  i->leaf = n != NULL ? as_leaf (n) : NULL;
+  i->idx = 0;
+  return btree_cur (i);
+}
+
+/* Points I at the first element of T not less than E and
+   returns it, or a null pointer if there is none. */
+struct btree_elem *
+btree_lower_bound (struct btree_iterator *i, struct btree *t,
+                   const struct btree_elem *e)
+{
+  ASSERT (i != NULL);
+  ASSERT (t != NULL);
+
+  i->leaf = t->root != NULL ? find_leaf (t, e) : NULL;
+  i->idx = i->leaf != NULL ? leaf_lower_bound (t, i->leaf, e) : 0;
+  return settle (i);
+}
+
+/* Points I at the first element of T greater than E and returns
+   it, or a null pointer if there is none. */
+struct btree_elem *
+btree_upper_bound (struct btree_iterator *i, struct btree *t,
+                   const struct btree_elem *e)
+{
+  ASSERT (i != NULL);
+  ASSERT (t != NULL);
+
+  i->leaf = t->root != NULL ? find_leaf (t, e) : NULL;
+  i->idx = i->leaf != NULL ? leaf_upper_bound (t, i->leaf, e) : 0;
+  return settle (i);
+}
+
+/* Advances I to the next element in order and returns it, or a
+   null pointer if no elements are left. */
+struct btree_elem *
+btree_next (struct btree_iterator *i)
+{
+  ASSERT (i != NULL);
+
+  if (i->leaf == NULL)
+    return NULL;
+  i->idx++;
+  return settle (i);
+}
+
+/* Moves I back to the previous element in order and returns it.
+   Returns a null pointer, leaving I unchanged, if I is at the
+   first element or at the end of the tree. */
+struct btree_elem *
+btree_prev (struct btree_iterator *i)
+{
+  ASSERT (i != NULL);
+
+  if (i->leaf == NULL)
+    return NULL;
+  if (i->idx > 0)
+    i->idx--;
+  else if (i->leaf->prev != NULL)
+    {
+      i->leaf = i->leaf->prev;
+      i->idx = i->leaf->node.cnt - 1;
+    }
+  else
+    return NULL;
+  return btree_cur (i);
+}
+
+/* Returns the element I points to, or a null pointer at the end
+   of the tree. */
+struct btree_elem *
+btree_cur (struct btree_iterator *i)
+{
+  return i->leaf != NULL ? i->leaf->elems[i->idx] : NULL;
+}
+
+/* Calls ACTION for each element of T, in order.  ACTION must not
+   modify T. */
+void
+btree_apply (struct btree *t, btree_action_func *action)
+{
+  btree_apply_range (t, NULL, NULL, action);
+}
+
+/* Calls ACTION, in order, for each element E of T with LO <= E
+   and E < HI.  A null LO or HI leaves that end of the range
+   open.  ACTION must not modify T. */
+void
+btree_apply_range (struct btree *t, const struct btree_elem *lo,
+                   const struct btree_elem *hi, btree_action_func *action)
+{
+  struct btree_iterator i;
+  struct btree_elem *e;
+
+  ASSERT (t != NULL);
+  ASSERT (action != NULL);
+
+  e = lo != NULL ? btree_lower_bound (&i, t, lo) : btree_first (&i, t);
+  for (; e != NULL; e = btree_next (&i))
+    {
+      if (hi != NULL && !t->less (e, hi, t->aux))
+        break;
+      action (e, t->aux);
+    }
+}
+
+/* Returns the number of elements in T. */
+size_t
+btree_size (struct btree *t)
+{
+  return t->elem_cnt;
+}
+
+/* Returns true if T contains no elements, false otherwise. */
+bool
+btree_empty (struct btree *t)
+{
+  return t->elem_cnt == 0;
+}
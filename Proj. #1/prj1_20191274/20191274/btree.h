@@ -0,0 +1,121 @@
+#ifndef __MYLIB_BTREE_H
+#define __MYLIB_BTREE_H
+
+/* Ordered map (B+-tree).
+
+   A hash table finds an element quickly but keeps no order, so
+   sorted output or a range query means copying everything into a
+   list and sorting it.  A B+-tree keeps its elements sorted by a
+   `less' function of the same kind the hash table uses, and
+   supports O(log n) insertion, search and deletion, in-order
+   iteration, lower_bound/upper_bound, and range scans.
+
+   Every element lives in a leaf, and the leaves are linked in
+   order, so iteration walks arrays of element pointers rather
+   than chasing one pointer per element.  Inner nodes hold only
+   separator keys (pointers to the smallest element of each
+   subtree but the first) and children.  A node holds up to 32
+   entries, so a lookup touches a handful of cache-friendly nodes
+   even in a large tree.
+
+   As with the hash table, each element embeds a struct
+   btree_elem, and btree_entry() converts a struct btree_elem
+   back into the structure that contains it.  The tree stores
+   pointers to elements, so the elements are never moved or
+   copied, and equal elements are never both inserted.
+
+      struct btree tree;
+      struct btree_iterator i;
+      struct btree_elem *e;
+
+      btree_init (&tree, foo_less, NULL);
+      btree_insert (&tree, &foo->elem);
+      for (e = btree_first (&i, &tree); e != NULL; e = btree_next (&i))
+        {
+          struct foo *f = btree_entry (e, struct foo, elem);
+          ...do something with f...
+        }
+
+   Modifying a tree while iterating over it invalidates all
+   iterators. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* B+-tree element.  The tree links its elements from its own
+   nodes, so an element needs no links of its own, and the tree
+   never looks inside one; the key lives in the structure that
+   embeds it.  C does not allow an empty structure, hence the
+   placeholder. */
+struct btree_elem
+  {
+    char unused;
+  };
+
+/* Converts pointer to B+-tree element BTREE_ELEM into a pointer
+   to the structure that BTREE_ELEM is embedded inside.  Supply
+   the name of the outer structure STRUCT and the member name
+   MEMBER of the B+-tree element. */
+#define btree_entry(BTREE_ELEM, STRUCT, MEMBER)                 \
+        ((STRUCT *) ((uint8_t *) (BTREE_ELEM)                   \
+                     - offsetof (STRUCT, MEMBER)))
+
+/* Compares the value of two B+-tree elements A and B, given
+   auxiliary data AUX.  Returns true if A is less than B, or
+   false if A is greater than or equal to B. */
+typedef bool btree_less_func (const struct btree_elem *a,
+                              const struct btree_elem *b,
+                              void *aux);
+
+/* Performs some operation on B+-tree element E, given auxiliary
+   data AUX. */
+typedef void btree_action_func (struct btree_elem *e, void *aux);
+
+struct btree_node;
+struct btree_leaf;
+
+/* B+-tree. */
+struct btree
+  {
+    struct btree_node *root;    /* Root node, or null if empty. */
+    size_t elem_cnt;            /* Number of elements in tree. */
+    btree_less_func *less;      /* Comparison function. */
+    void *aux;                  /* Auxiliary data for `less'. */
+  };
+
+/* A B+-tree iterator. */
+struct btree_iterator
+  {
+    struct btree_leaf *leaf;    /* Current leaf, or null at the end. */
+    int idx;                    /* Current element within `leaf'. */
+  };
+
+/* Basic life cycle. */
+void btree_init (struct btree *, btree_less_func *, void *aux);
+void btree_clear (struct btree *, btree_action_func *);
+void btree_destroy (struct btree *, btree_action_func *);
+
+/* Search, insertion, deletion. */
+struct btree_elem *btree_insert (struct btree *, struct btree_elem *);
+struct btree_elem *btree_find (struct btree *, const struct btree_elem *);
+struct btree_elem *btree_delete (struct btree *, const struct btree_elem *);
+
+/* Ordered iteration. */
+struct btree_elem *btree_first (struct btree_iterator *, struct btree *);
+struct btree_elem *btree_lower_bound (struct btree_iterator *, struct btree *,
+                                      const struct btree_elem *);
+struct btree_elem *btree_upper_bound (struct btree_iterator *, struct btree *,
+                                      const struct btree_elem *);
+struct btree_elem *btree_next (struct btree_iterator *);
+struct btree_elem *btree_prev (struct btree_iterator *);
+struct btree_elem *btree_cur (struct btree_iterator *);
+void btree_apply (struct btree *, btree_action_func *);
+void btree_apply_range (struct btree *, const struct btree_elem *lo,
+                        const struct btree_elem *hi, btree_action_func *);
+
+/* Information. */
+size_t btree_size (struct btree *);
+bool btree_empty (struct btree *);
+
+#endif /* btree.h */
@@ -0,0 +1,310 @@
+/* Bounded cache.
+
+See cache.h for basic information. */
+
+#include "cache.h"
+#include <assert.h>
+
+#define ASSERT(CONDITION) assert(CONDITION)
+
+#define hash_to_cache_elem(HASH_ELEM)                           \
+        cache_entry (HASH_ELEM, struct cache_elem, hash_elem)
+#define list_to_cache_elem(LIST_ELEM)                           \
+        list_entry (LIST_ELEM, struct cache_elem, list_elem)
+
+/* Calls the hash function of cache C_ on E. */
+static unsigned
+cache_hash (const struct hash_elem *e, void *c_)
+{
+  struct cache *c = c_;
+  return c->hash (hash_to_cache_elem (e), c->aux);
+}
+
+/* Calls the comparison function of cache C_ on A and B. */
+static bool
+cache_less (const struct hash_elem *a, const struct hash_elem *b, void *c_)
+{
+  struct cache *c = c_;
+  return c->less (hash_to_cache_elem (a), hash_to_cache_elem (b), c->aux);
+}
+
+/* Initializes C as an empty cache of at most CAPACITY elements,
+   evicting by POLICY, and computing hash values and comparing
+   elements with HASH and LESS, given auxiliary data AUX.  The
+   table is sized for CAPACITY elements up front, so it never
+   resizes.  Returns false if memory is exhausted. */
+bool
+cache_init (struct cache *c, size_t capacity, enum cache_policy policy,
+            cache_hash_func *hash, cache_less_func *less, void *aux)
+{
+  ASSERT (c != NULL);
+  ASSERT (capacity > 0);
+  ASSERT (hash != NULL);
+  ASSERT (less != NULL);
+
+  c->hash = hash;
+  c->less = less;
+  c->aux = aux;
+  if (!hash_init (&c->table, cache_hash, cache_less, c))
+    return false;
+  if (!hash_reserve (&c->table, capacity))
+    {
+      hash_destroy (&c->table, NULL);
+      return false;
+    }
+  list_init (&c->order);
+  c->hand = NULL;
+  c->capacity = capacity;
+  c->policy = policy;
+  c->hit_cnt = 0;
+  c->miss_cnt = 0;
+  c->evict_cnt = 0;
+  return true;
+}
+
+/* Removes all the elements from C, calling DESTRUCTOR, if it is
+   non-null, for each of them.  The counters are kept. */
+void
+cache_clear (struct cache *c, cache_action_func *destructor)
+{
+  ASSERT (c != NULL);
+
+  hash_clear (&c->table, NULL);
+  while (!list_empty (&c->order))
+    {
+      struct cache_elem *e = list_to_cache_elem (list_pop_front (&c->order));
+      if (destructor != NULL)
+        destructor (e, c->aux);
+    }
+  c->hand = NULL;
+}
+
+/* Destroys cache C, calling DESTRUCTOR, if it is non-null, for
+   each of its elements. */
+void
+cache_destroy (struct cache *c, cache_action_func *destructor)
+{
+  cache_clear (c, destructor);
+  hash_destroy (&c->table, NULL);
+}
+
+/* Returns the element after E in C's clock ring. */
+static struct list_elem *
+ring_next (struct cache *c, struct list_elem *e)
+{
+  e = list_next (e);
+  return e != list_end (&c->order) ? e : list_begin (&c->order);
+}
+
+/* Takes E, which is in C, out of C's eviction order, moving the
+   clock hand off it first. */
+static void
+unlink_elem (struct cache *c, struct cache_elem *e)
+{
+  if (c->hand == &e->list_elem)
+    {
+      c->hand = ring_next (c, c->hand);
+      if (c->hand == &e->list_elem)
+        c->hand = NULL;
+    }
+  list_remove (&e->list_elem);
+}
+
+/* Records a use of E, which is in C. */
+static void
+touch (struct cache *c, struct cache_elem *e)
+{
+  if (c->policy == CACHE_CLOCK)
+    e->referenced = true;
+  else if (&e->list_elem != list_front (&c->order))
+    {
+      list_remove (&e->list_elem);
+      list_push_front (&c->order, &e->list_elem);
+    }
+}
+
+/* Returns the element C should evict next, which is not
+   necessarily its only element: with CACHE_CLOCK, the hand
+   first clears the reference bits in its way. */
+static struct cache_elem *
+choose_victim (struct cache *c)
+{
+  struct cache_elem *e;
+
+  if (c->policy == CACHE_LRU)
+    return list_to_cache_elem (list_back (&c->order));
+
+  for (;;)
+    {
+      e = list_to_cache_elem (c->hand);
+      if (!e->referenced)
+        return e;
+      e->referenced = false;
+      c->hand = ring_next (c, c->hand);
+    }
+}
+
+/* Finds and returns the element of C equal to KEY, or a null
+   pointer if there is none, and counts a hit or a miss.  An
+   element found counts as used. */
+struct cache_elem *
+cache_get (struct cache *c, struct cache_elem *key)
+{
+  struct hash_elem *found;
+  struct cache_elem *e;
+
+  ASSERT (c != NULL);
+  ASSERT (key != NULL);
+
+  found = hash_find (&c->table, &key->hash_elem);
+  if (found == NULL)
+    {
+      c->miss_cnt++;
+      return NULL;
+    }
+  c->hit_cnt++;
+  e = hash_to_cache_elem (found);
+  touch (c, e);
+  return e;
+}
+
+/* Finds and returns the element of C equal to KEY, or a null
+   pointer if there is none, like cache_get(), but neither counts
+   the search nor treats the element as used. */
+struct cache_elem *
+cache_peek (struct cache *c, struct cache_elem *key)
+{
+  struct hash_elem *found;
+
+  ASSERT (c != NULL);
+  ASSERT (key != NULL);
+
+  found = hash_find (&c->table, &key->hash_elem);
+  return found != NULL ? hash_to_cache_elem (found) : NULL;
+}
+
+/* Inserts NEW into C, as a just-used element, and returns the
+   element it displaced, if any: an equal element already in C,
+   which NEW replaces, or, if C was full, the element evicted to
+   make room.  Either way, the element returned is no longer in
+   C, and deallocating it is up to the caller.  Returns a null
+   pointer if nothing was displaced. */
+struct cache_elem *
+cache_put (struct cache *c, struct cache_elem *new)
+{
+  struct hash_elem *old_;
+  struct cache_elem *old;
+
+  ASSERT (c != NULL);
+  ASSERT (new != NULL);
+
+  /* New elements start out referenced, so that the hand, even
+     after clearing every other bit, comes back around to an
+     older element before reaching NEW. */
+  new->referenced = true;
+  old_ = hash_replace (&c->table, &new->hash_elem);
+  if (old_ != NULL)
+    {
+      old = hash_to_cache_elem (old_);
+      if (c->policy == CACHE_CLOCK)
+        {
+          /* NEW takes OLD's place in the ring. */
+          list_insert (&old->list_elem, &new->list_elem);
+          if (c->hand == &old->list_elem)
+            c->hand = &new->list_elem;
+          list_remove (&old->list_elem);
+        }
+      else
+        {
+          list_remove (&old->list_elem);
+          list_push_front (&c->order, &new->list_elem);
+        }
+      return old;
+    }
+
+  /* A new element goes at the front of the LRU order, or just
+     behind the hand, where the hand reaches it last. */
+  if (c->policy == CACHE_CLOCK && c->hand != NULL)
+    list_insert (c->hand, &new->list_elem);
+  else
+    {
+      list_push_front (&c->order, &new->list_elem);
+      if (c->policy == CACHE_CLOCK)
+        c->hand = &new->list_elem;
+    }
+  if (hash_size (&c->table) <= c->capacity)
+    return NULL;
+
+  /* The victim is unlinked by pointer, with no second search. */
+  old = choose_victim (c);
+  unlink_elem (c, old);
+  hash_remove (&c->table, &old->hash_elem);
+  c->evict_cnt++;
+  return old;
+}
+
+/* Finds, removes, and returns the element of C equal to KEY, or
+   returns a null pointer if there is none.  Deallocating it is up
+   to the caller. */
+struct cache_elem *
+cache_delete (struct cache *c, struct cache_elem *key)
+{
+  struct hash_elem *found;
+  struct cache_elem *e;
+
+  ASSERT (c != NULL);
+  ASSERT (key != NULL);
+
+  found = hash_delete (&c->table, &key->hash_elem);
+  if (found == NULL)
+    return NULL;
+  e = hash_to_cache_elem (found);
+  unlink_elem (c, e);
+  return e;
+}
+
+/* Calls ACTION for each element of C, in eviction order reversed:
+   most recently used first for CACHE_LRU, and for CACHE_CLOCK
+   starting just behind the hand and going backward, so that the
+   element the hand examines next comes last.  ACTION must not
+   modify C. */
+void
+cache_apply (struct cache *c, cache_action_func *action)
+{
+  struct list_elem *e;
+
+  ASSERT (c != NULL);
+  ASSERT (action != NULL);
+
+  if (c->policy == CACHE_LRU || c->hand == NULL)
+    {
+      for (e = list_begin (&c->order); e != list_end (&c->order);
+           e = list_next (e))
+        action (list_to_cache_elem (e), c->aux);
+      return;
+    }
+
+  e = c->hand;
+  do
+    {
+      e = list_prev (e);
+      if (e == list_head (&c->order))
+        e = list_back (&c->order);
+      action (list_to_cache_elem (e), c->aux);
+    }
+  while (e != c->hand);
+}
+
+/* Returns the number of elements in C. */
+size_t
+cache_size (struct cache *c)
+{
+  return hash_size (&c->table);
+}
+
+/* Returns the most elements C holds. */
+size_t
+cache_capacity (struct cache *c)
+{
+  return c->capacity;
+}
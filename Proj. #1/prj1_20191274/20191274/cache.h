@@ -0,0 +1,127 @@
+#ifndef __MYLIB_CACHE_H
+#define __MYLIB_CACHE_H
+
+/* Bounded cache.
+
+   A cache holds at most a fixed number of elements, and makes
+   room for a new one by evicting one it expects to be needed
+   least.  It is a hash table, to find elements, combined with a
+   list, to order them for eviction.  Each element embeds a
+   struct cache_elem, which holds both a struct hash_elem and a
+   struct list_elem, so an element is a single allocation and
+   getting, putting and evicting it are all O(1).
+
+   Two eviction policies are offered:
+
+     - CACHE_LRU evicts the least recently used element.  The
+       list is kept in order of use, most recent first, so every
+       hit moves an element to the front.
+
+     - CACHE_CLOCK approximates LRU more cheaply.  The list is a
+       ring swept by a "hand", and a hit only sets the element's
+       reference bit.  To evict, the hand passes over elements
+       whose bit is set, clearing it, and evicts the first one
+       whose bit is clear.  Hits never touch the list, which
+       matters when they far outnumber misses.
+
+   The cache does not allocate or free elements.  cache_put()
+   returns the element it displaced, if any, for the caller to
+   free:
+
+      struct cache c;
+
+      cache_init (&c, 1024, CACHE_LRU, foo_hash, foo_less, NULL);
+      ...
+      found = cache_get (&c, &key.elem);
+      if (found == NULL)
+        {
+          ...compute foo, the value for key...
+          old = cache_put (&c, &foo->elem);
+          if (old != NULL)
+            free (cache_entry (old, struct foo, elem));
+        }
+
+   The hash and comparison functions take struct cache_elems,
+   and are otherwise like those of hash.h.  The counters
+   `hit_cnt', `miss_cnt' and `evict_cnt' in struct cache may be
+   read directly.  A cache must not be moved or copied once
+   initialized. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "hash.h"
+#include "list.h"
+
+/* Cache element. */
+struct cache_elem
+  {
+    struct hash_elem hash_elem; /* In the cache's hash table. */
+    struct list_elem list_elem; /* In its eviction order. */
+    bool referenced;            /* CACHE_CLOCK: used since the hand passed? */
+  };
+
+/* Converts pointer to cache element CACHE_ELEM into a pointer to
+   the structure that CACHE_ELEM is embedded inside.  Supply the
+   name of the outer structure STRUCT and the member name MEMBER
+   of the cache element. */
+#define cache_entry(CACHE_ELEM, STRUCT, MEMBER)                 \
+        ((STRUCT *) ((uint8_t *) (CACHE_ELEM)                   \
+                     - offsetof (STRUCT, MEMBER)))
+
+/* Computes and returns the hash value for cache element E, given
+   auxiliary data AUX. */
+typedef unsigned cache_hash_func (const struct cache_elem *e, void *aux);
+
+/* Compares the keys of two cache elements A and B, given
+   auxiliary data AUX.  Returns true if A is less than B, or
+   false if A is greater than or equal to B. */
+typedef bool cache_less_func (const struct cache_elem *a,
+                              const struct cache_elem *b,
+                              void *aux);
+
+/* Performs some operation on cache element E, given auxiliary
+   data AUX. */
+typedef void cache_action_func (struct cache_elem *e, void *aux);
+
+/* Eviction policy. */
+enum cache_policy
+  {
+    CACHE_LRU,                  /* Least recently used. */
+    CACHE_CLOCK                 /* Clock (second chance). */
+  };
+
+/* Cache. */
+struct cache
+  {
+    struct hash table;          /* Elements, by key. */
+    struct list order;          /* Elements, in eviction order. */
+    struct list_elem *hand;     /* CACHE_CLOCK: next to examine. */
+    size_t capacity;            /* Maximum number of elements. */
+    enum cache_policy policy;   /* Eviction policy. */
+    cache_hash_func *hash;      /* Hash function. */
+    cache_less_func *less;      /* Comparison function. */
+    void *aux;                  /* Auxiliary data for `hash' and `less'. */
+    size_t hit_cnt;             /* cache_get() calls that found an element. */
+    size_t miss_cnt;            /* cache_get() calls that did not. */
+    size_t evict_cnt;           /* Elements evicted by cache_put(). */
+  };
+
+/* Basic life cycle. */
+bool cache_init (struct cache *, size_t capacity, enum cache_policy,
+                 cache_hash_func *, cache_less_func *, void *aux);
+void cache_clear (struct cache *, cache_action_func *);
+void cache_destroy (struct cache *, cache_action_func *);
+
+/* Search, insertion, deletion. */
+struct cache_elem *cache_get (struct cache *, struct cache_elem *);
+struct cache_elem *cache_peek (struct cache *, struct cache_elem *);
+struct cache_elem *cache_put (struct cache *, struct cache_elem *);
+struct cache_elem *cache_delete (struct cache *, struct cache_elem *);
+
+/* Iteration and information. */
+void cache_apply (struct cache *, cache_action_func *);
+size_t cache_size (struct cache *);
+size_t cache_capacity (struct cache *);
+
+#endif /* cache.h */
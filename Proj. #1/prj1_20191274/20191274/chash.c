@@ -0,0 +1,194 @@
+/* Concurrent hash table.
+
+See chash.h for basic information. */
+
+#include "chash.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define ASSERT(CONDITION) assert(CONDITION)
+
+/* Segments per online CPU when chash_init() picks the count. */
+#define SEGS_PER_CPU 4
+
+/* Returns the segment of C that elements equal to E belong in.
+   The segment comes from the low bits of the hash, while each
+   segment's table picks buckets from the high bits (see
+   bucket_index() in hash.c), so the two choices do not
+   interfere. */
+static struct chash_segment *
+find_segment (struct chash *c, struct hash_elem *e)
+{
+  return &c->segs[c->hash (e, c->aux) & (c->seg_cnt - 1)];
+}
+
+/* Initializes C as an empty concurrent hash table of SEG_CNT
+   segments, rounded up to a power of 2, using HASH, LESS and AUX
+   as hash_init() does.  If SEG_CNT is 0, uses SEGS_PER_CPU
+   segments for each online CPU.  Returns false if memory is
+   exhausted. */
+bool
+chash_init (struct chash *c, size_t seg_cnt,
+            hash_hash_func *hash, hash_less_func *less, void *aux)
+{
+  size_t i;
+
+  ASSERT (c != NULL);
+  ASSERT (hash != NULL);
+  ASSERT (less != NULL);
+
+  if (seg_cnt == 0)
+    {
+      long cpu_cnt = sysconf (_SC_NPROCESSORS_ONLN);
+      seg_cnt = SEGS_PER_CPU * (cpu_cnt > 0 ? (size_t) cpu_cnt : 1);
+    }
+  c->seg_cnt = 1;
+  while (c->seg_cnt < seg_cnt)
+    c->seg_cnt *= 2;
+
+  c->segs = malloc (sizeof *c->segs * c->seg_cnt);
+  if (c->segs == NULL)
+    return false;
+  c->hash = hash;
+  c->aux = aux;
+
+  for (i = 0; i < c->seg_cnt; i++)
+    {
+      if (!hash_init (&c->segs[i].table, hash, less, aux))
+        {
+          while (i-- > 0)
+            {
+              hash_destroy (&c->segs[i].table, NULL);
+              pthread_rwlock_destroy (&c->segs[i].lock);
+            }
+          free (c->segs);
+          return false;
+        }
+      pthread_rwlock_init (&c->segs[i].lock, NULL);
+    }
+  return true;
+}
+
+/* Makes every segment of C use EQ for equality, as
+   hash_set_eq() does. */
+void
+chash_set_eq (struct chash *c, hash_eq_func *eq)
+{
+  size_t i;
+
+  ASSERT (c != NULL);
+
+  for (i = 0; i < c->seg_cnt; i++)
+    hash_set_eq (&c->segs[i].table, eq);
+}
+
+/* Destroys C, calling DESTRUCTOR, if non-null, for each element
+   first, as hash_destroy() does.  No other thread may be using
+   C. */
+void
+chash_destroy (struct chash *c, hash_action_func *destructor)
+{
+  size_t i;
+
+  ASSERT (c != NULL);
+
+  for (i = 0; i < c->seg_cnt; i++)
+    {
+      hash_destroy (&c->segs[i].table, destructor);
+      pthread_rwlock_destroy (&c->segs[i].lock);
+    }
+  free (c->segs);
+  c->segs = NULL;
+  c->seg_cnt = 0;
+}
+
+/* Inserts NEW into C like hash_insert(). */
+struct hash_elem *
+chash_insert (struct chash *c, struct hash_elem *new)
+{
+  struct chash_segment *seg = find_segment (c, new);
+  struct hash_elem *old;
+
+  pthread_rwlock_wrlock (&seg->lock);
+  old = hash_insert (&seg->table, new);
+  pthread_rwlock_unlock (&seg->lock);
+  return old;
+}
+
+/* Inserts NEW into C like hash_replace(). */
+struct hash_elem *
+chash_replace (struct chash *c, struct hash_elem *new)
+{
+  struct chash_segment *seg = find_segment (c, new);
+  struct hash_elem *old;
+
+  pthread_rwlock_wrlock (&seg->lock);
+  old = hash_replace (&seg->table, new);
+  pthread_rwlock_unlock (&seg->lock);
+  return old;
+}
+
+/* Finds an element equal to E in C like hash_find().  Takes only
+   a read lock, so lookups run in parallel with each other. */
+struct hash_elem *
+chash_find (struct chash *c, struct hash_elem *e)
+{
+  struct chash_segment *seg = find_segment (c, e);
+  struct hash_elem *found;
+
+  pthread_rwlock_rdlock (&seg->lock);
+  found = hash_find (&seg->table, e);
+  pthread_rwlock_unlock (&seg->lock);
+  return found;
+}
+
+/* Deletes an element equal to E from C like hash_delete(). */
+struct hash_elem *
+chash_delete (struct chash *c, struct hash_elem *e)
+{
+  struct chash_segment *seg = find_segment (c, e);
+  struct hash_elem *found;
+
+  pthread_rwlock_wrlock (&seg->lock);
+  found = hash_delete (&seg->table, e);
+  pthread_rwlock_unlock (&seg->lock);
+  return found;
+}
+
+/* Calls ACTION for each element of C, one segment at a time,
+   holding that segment's write lock.  ACTION must not change the
+   hash value of an element, nor call any chash_* function on
+   C. */
+void
+chash_apply (struct chash *c, hash_action_func *action)
+{
+  size_t i;
+
+  ASSERT (action != NULL);
+
+  for (i = 0; i < c->seg_cnt; i++)
+    {
+      pthread_rwlock_wrlock (&c->segs[i].lock);
+      hash_apply (&c->segs[i].table, action);
+      pthread_rwlock_unlock (&c->segs[i].lock);
+    }
+}
+
+/* Returns the number of elements in C.  Segments are counted
+   one at a time, so the result may be stale if other threads
+   are changing C. */
+size_t
+chash_size (struct chash *c)
+{
+  size_t cnt = 0;
+  size_t i;
+
+  for (i = 0; i < c->seg_cnt; i++)
+    {
+      pthread_rwlock_rdlock (&c->segs[i].lock);
+      cnt += hash_size (&c->segs[i].table);
+      pthread_rwlock_unlock (&c->segs[i].lock);
+    }
+  return cnt;
+}
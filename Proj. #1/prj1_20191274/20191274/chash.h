@@ -0,0 +1,74 @@
+#ifndef __MYLIB_CHASH_H
+#define __MYLIB_CHASH_H
+
+/* Concurrent hash table.
+
+   A `struct hash' must not be used from more than one thread at
+   a time.  A `struct chash' may: it splits its elements among a
+   number of segments ("lock striping"), each of which is an
+   ordinary chained `struct hash' guarded by its own reader-writer
+   lock.  An element's segment is chosen from its hash value, so
+   operations on different segments never wait for each other,
+   and any number of chash_find() calls on the same segment run in
+   parallel.
+
+   Each segment grows and shrinks on its own, under its write
+   lock, using the incremental rehash of hash.c.  A resize
+   therefore holds up only the readers of one segment, and only
+   for the few buckets migrated by one operation, never for the
+   time it takes to move a whole table.
+
+   The elements are the same `struct hash_elem's used by hash.h,
+   with the same hash and comparison functions:
+
+      struct chash table;
+
+      chash_init (&table, 0, foo_hash, foo_less, NULL);
+      ...in any thread...
+      old = chash_insert (&table, &foo->elem);
+      found = chash_find (&table, &key.elem);
+
+   chash_find() returns a pointer to an element that other threads
+   may delete as soon as the segment lock is dropped.  Callers
+   that free deleted elements must make sure no other thread is
+   still using them. */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "hash.h"
+
+/* One lock stripe: a hash table and the lock that guards it. */
+struct chash_segment
+  {
+    pthread_rwlock_t lock;      /* Guards `table'. */
+    struct hash table;          /* This segment's elements. */
+  };
+
+/* Concurrent hash table. */
+struct chash
+  {
+    size_t seg_cnt;                     /* Number of segments, a power of 2. */
+    struct chash_segment *segs;         /* Array of `seg_cnt' segments. */
+    hash_hash_func *hash;               /* Hash function. */
+    void *aux;                          /* Auxiliary data for `hash'. */
+  };
+
+/* Basic life cycle.  Not thread-safe. */
+bool chash_init (struct chash *, size_t seg_cnt,
+                 hash_hash_func *, hash_less_func *, void *aux);
+void chash_set_eq (struct chash *, hash_eq_func *);
+void chash_destroy (struct chash *, hash_action_func *);
+
+/* Search, insertion, deletion.  Thread-safe. */
+struct hash_elem *chash_insert (struct chash *, struct hash_elem *);
+struct hash_elem *chash_replace (struct chash *, struct hash_elem *);
+struct hash_elem *chash_find (struct chash *, struct hash_elem *);
+struct hash_elem *chash_delete (struct chash *, struct hash_elem *);
+
+/* Iteration and information.  Thread-safe, but not atomic with
+   respect to changes made concurrently. */
+void chash_apply (struct chash *, hash_action_func *);
+size_t chash_size (struct chash *);
+
+#endif /* chash.h */
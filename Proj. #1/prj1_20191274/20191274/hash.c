@@ -3,23 +3,107 @@
 See hash.h for basic information. */
 
 #include "hash.h"
+#include "bitmap.h"
+#include "btree.h"
+#include "snapshot.h"
 #include <assert.h>	
 #include <stdlib.h>	
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #define ASSERT(CONDITION) assert(CONDITION)
-
-#define list_elem_to_hash_elem(LIST_ELEM)                       \
-        list_entry(LIST_ELEM, struct hash_elem, list_elem)
-/* 
-Convert list_elem to hash_elem... 
-*/
-
-static struct list *find_bucket (struct hash *, struct hash_elem *);
-static struct hash_elem *find_elem (struct hash *, struct list *,
-                                    struct hash_elem *);
-static void insert_elem (struct hash *, struct list *, struct hash_elem *);
-static void remove_elem (struct hash *, struct hash_elem *);
+#define UNUSED __attribute__ ((unused))
+
+#define MIN_BUCKET_CNT 4        /* Never fewer buckets than this. */
+
+/* A chain of more than TREEIFY_LEN elements is indexed by a
+   tree, until it is down to fewer than UNTREEIFY_LEN.  The gap
+   keeps a chain whose length hovers around the limit from
+   building and dropping its tree over and over. */
+#define TREEIFY_LEN 16
+#define UNTREEIFY_LEN 12
+
+/* Tree index of a long chain.  It orders the chain's elements by
+   cached hash value, then by `less'.  btree.c never looks inside
+   the elements it holds, only passes them to tree_less(), so it
+   can hold struct hash_elems in place of struct btree_elems. */
+struct hash_tree
+  {
+    struct btree tree;          /* The chain's elements. */
+    hash_less_func *less;       /* The table's `less'... */
+    void *aux;                  /* ...and its auxiliary data. */
+  };
+
+#define hash_to_btree_elem(HASH_ELEM) ((struct btree_elem *) (HASH_ELEM))
+#define btree_to_hash_elem(BTREE_ELEM) ((struct hash_elem *) (BTREE_ELEM))
+
+static inline bool elem_equal (struct hash *, struct hash_elem *,
+                               struct hash_elem *);
+static inline bool elem_matches (struct hash *, struct hash_elem *,
+                                 const void *key, hash_key_eq_func *);
+static inline void count_lookup (struct hash *, size_t probe_cnt);
+static uint64_t now_ns (void);
+static uint64_t coarse_ns (void);
+static inline size_t bucket_index (unsigned hash, size_t bucket_cnt);
+static struct hash_elem **find_bucket (struct hash *, unsigned hash);
+static struct hash_elem *find_elem (struct hash *, struct hash_elem **bucket,
+                                    const void *key, hash_key_eq_func *,
+                                    unsigned hash, struct hash_elem ***link);
+static void insert_elem (struct hash *, struct hash_elem **bucket,
+                         struct hash_elem *, unsigned hash);
+static void link_elem (struct hash *, struct hash_elem **bucket,
+                       struct hash_elem *);
+static void remove_elem (struct hash *, struct hash_elem **bucket,
+                         struct hash_elem **link);
 static void rehash (struct hash *);
+static size_t best_bucket_cnt (size_t elem_cnt);
+static bool start_rehash (struct hash *, size_t bucket_cnt);
+static void migrate (struct hash *, size_t bucket_cnt);
+static struct hash_elem **next_bucket (struct hash *, struct hash_elem **);
+static void set_occupied (struct hash *, struct hash_elem **, bool);
+static size_t bloom_bit_cnt (size_t bucket_cnt);
+static void bloom_add (struct bitmap *, unsigned hash);
+static bool bloom_test (const struct bitmap *, unsigned hash);
+static inline void count_bloom (struct hash *, size_t *cnt);
+static inline uint64_t fmix64 (uint64_t);
+static inline unsigned seed_hash (const struct hash *, unsigned hash);
+static struct hash_tree **tree_slot (struct hash *, struct hash_elem **);
+static struct hash_elem *tree_find (struct hash_tree *, const void *key,
+                                    hash_key_eq_func *, unsigned hash,
+                                    void *aux, size_t *probe_cnt);
+static struct hash_elem **tree_link (struct hash_tree *,
+                                     struct hash_elem **bucket,
+                                     struct hash_elem *);
+static void treeify (struct hash *, struct hash_elem **);
+static void drop_tree (struct hash *, struct hash_tree **);
+static void drop_trees (struct hash *, struct hash_tree ***, size_t cnt);
+static bool chain_longer_than (struct hash_elem *, size_t len);
+
+static bool open_init (struct hash *, size_t slot_cnt);
+static void open_clear (struct hash *, hash_action_func *);
+static struct hash_elem *open_insert (struct hash *, struct hash_elem *,
+                                      bool replace);
+static struct hash_elem *open_lookup (struct hash *, unsigned hash,
+                                      const void *key, hash_key_eq_func *,
+                                      size_t *slot);
+static struct hash_elem *open_find (struct hash *, struct hash_elem *,
+                                    size_t *slot);
+static struct hash_elem *open_delete (struct hash *, struct hash_elem *);
+static void open_remove (struct hash *, size_t slot);
+static void open_place (struct hash *, unsigned hash, struct hash_elem *);
+static bool open_make_room (struct hash *);
+static struct hash_elem *open_upsert (struct hash *, const void *key,
+                                      unsigned hash, hash_key_eq_func *,
+                                      hash_make_func *, hash_action_func *);
+static bool open_reserve (struct hash *, size_t elem_cnt);
+static void open_shrink_to_fit (struct hash *);
+static size_t open_next_full (struct hash *, size_t slot);
+static size_t open_chain_len (struct hash *, size_t slot);
 
 /* Initializes hash table H to compute hash values using HASH and
    compare hash elements using LESS, given auxiliary data AUX. */
@@ -35,15 +119,147 @@ hash_hash_func() : key ~~>> hash .
   h->buckets = malloc (sizeof *h->buckets * h->bucket_cnt);
   h->hash = hash; // hash : hashfunc().
   h->less = less; // less : compareFunc().
+  h->eq = NULL; // equality via less(), until hash_set_eq().
   h->aux = aux; // don't care...
-
-  if (h->buckets != NULL) 
+  h->min_bucket_cnt = MIN_BUCKET_CNT; // never shrink below the initial size.
+  h->old_buckets = NULL; // no rehash in progress.
+  h->old_bucket_cnt = 0;
+  h->migrate_idx = 0;
+  h->old_occupied = NULL;
+  h->bloom = NULL; // no Bloom filter until hash_set_bloom().
+  h->next_bloom = NULL;
+  h->trees = NULL; // no long chains yet.
+  h->old_trees = NULL;
+  h->tree_cnt = 0;
+  h->seed = hash_new_seed (); // differs from table to table.
+  h->ctrl = NULL; // chaining, not open addressing.
+  h->slots = NULL;
+  h->growth_left = 0;
+  h->rehash_cnt = 0;
+  h->rehash_ns = 0;
+  h->count_searches = false;
+  h->lookup_cnt = 0;
+  h->probe_cnt = 0;
+  h->bloom_neg_cnt = 0;
+  h->bloom_fp_cnt = 0;
+
+  h->occupied = bitmap_create (h->bucket_cnt); // non-empty buckets.
+  if (h->buckets != NULL && h->occupied != NULL) 
     {
       hash_clear (h, NULL); // each bucket = NULL;...
       return true;
     }
   else
+    {
+      free (h->buckets);
+      bitmap_destroy (h->occupied);
+      return false;
+    }
+}
+
+/* Initializes hash table H like hash_init(), except that H uses
+   open addressing with SIMD group probing instead of chaining.
+   See hash.h for a description. */
+bool
+hash_init_open (struct hash *h,
+                hash_hash_func *hash, hash_less_func *less, void *aux)
+{
+  h->elem_cnt = 0;
+  h->buckets = NULL;
+  h->old_buckets = NULL;
+  h->old_bucket_cnt = 0;
+  h->migrate_idx = 0;
+  h->occupied = NULL;
+  h->old_occupied = NULL;
+  h->bloom = NULL;
+  h->next_bloom = NULL;
+  h->trees = NULL;
+  h->old_trees = NULL;
+  h->tree_cnt = 0;
+  h->seed = hash_new_seed ();
+  h->hash = hash;
+  h->less = less;
+  h->eq = NULL;
+  h->aux = aux;
+  h->rehash_cnt = 0;
+  h->rehash_ns = 0;
+  h->count_searches = false;
+  h->lookup_cnt = 0;
+  h->probe_cnt = 0;
+  h->bloom_neg_cnt = 0;
+  h->bloom_fp_cnt = 0;
+  return open_init (h, 0);
+}
+
+/* Makes H decide whether two elements are equal by calling EQ,
+   given H's auxiliary data, instead of calling its `less'
+   function twice.  EQ must agree with `less': two elements are
+   equal exactly when neither is less than the other.  A null EQ
+   goes back to using `less'. */
+void
+hash_set_eq (struct hash *h, hash_eq_func *eq)
+{
+  ASSERT (h != NULL);
+
+  h->eq = eq;
+}
+
+/* Makes H count its searches for hash_stats() if ENABLE is true,
+   or stop counting them if it is false.  Counting is off by
+   default: it writes to H on every search, even hash_find(), so
+   threads searching H at once (see chash.h) would all write to
+   the same cache line.  Turning counting on or off leaves the
+   counts made so far. */
+void
+hash_set_stats (struct hash *h, bool enable)
+{
+  ASSERT (h != NULL);
+
+  h->count_searches = enable;
+}
+
+/* Attaches a Bloom filter to H if ENABLE is true, or removes it
+   if ENABLE is false.  Returns false if memory is exhausted or H
+   uses open addressing, whose control bytes already filter most
+   misses; H is then left without a filter.
+
+   The filter holds BLOOM_HASH_CNT bits for each element's hash.
+   A search whose bits are not all set ends there: the element is
+   certainly absent.  Deleting an element cannot clear its bits,
+   which are shared, so deletions make the filter less selective
+   until the next rehash rebuilds it from the elements present.
+   hash_stats() reports how often the filter ends a search and
+   how often it lets through one that finds nothing.  Calling
+   this function with ENABLE true on a table that already has a
+   filter rebuilds it on the spot. */
+bool
+hash_set_bloom (struct hash *h, bool enable)
+{
+  struct hash_elem **bucket;
+
+  ASSERT (h != NULL);
+
+  bitmap_destroy (h->bloom);
+  bitmap_destroy (h->next_bloom);
+  h->bloom = h->next_bloom = NULL;
+  if (!enable)
+    return true;
+  if (h->slots != NULL)
+    return false;
+
+  migrate (h, SIZE_MAX);
+  h->bloom = bitmap_create (bloom_bit_cnt (h->bucket_cnt));
+  if (h->bloom == NULL)
     return false;
+  /* After the migration, every element is in `buckets'. */
+  for (bucket = h->buckets; bucket != NULL; bucket = next_bucket (h, bucket))
+    {
+      struct hash_elem *e;
+
+      for (e = *bucket; e != NULL; e = e->next)
+        bloom_add (h->bloom, e->hash);
+    }
+  return true;
 }
 
 /* Removes all the elements from H.
@@ -66,20 +282,60 @@ hash_clear (struct hash *h, hash_action_func *destructor)
 {
   size_t i;
 
+  if (h->slots != NULL)
+    {
+      open_clear (h, destructor);
+      return;
+    }
+
   for (i = 0; i < h->bucket_cnt; i++) 
     {
-      struct list *bucket = &h->buckets[i];
+      struct hash_elem **bucket = &h->buckets[i];
 
       if (destructor != NULL) 
-        while (!list_empty (bucket)) 
+        while (*bucket != NULL) 
           {
-            struct list_elem *list_elem = list_pop_front (bucket);
-            struct hash_elem *hash_elem = list_elem_to_hash_elem (list_elem);
+            struct hash_elem *hash_elem = *bucket;
+            *bucket = hash_elem->next;
             destructor (hash_elem, h->aux);
           }
 
-      list_init (bucket); 
+      *bucket = NULL; 
     }    
+  bitmap_set_all (h->occupied, false);
+  drop_trees (h, &h->trees, h->bucket_cnt);
+  drop_trees (h, &h->old_trees, h->old_bucket_cnt);
+
+  /* Elements still waiting to be migrated go the same way. */
+  if (destructor != NULL)
+    for (i = h->migrate_idx; i < h->old_bucket_cnt; i++)
+      {
+        struct hash_elem **bucket = &h->old_buckets[i];
+
+        while (*bucket != NULL)
+          {
+            struct hash_elem *hash_elem = *bucket;
+            *bucket = hash_elem->next;
+            destructor (hash_elem, h->aux);
+          }
+      }
+  free (h->old_buckets);
+  bitmap_destroy (h->old_occupied);
+  h->old_buckets = NULL;
+  h->old_occupied = NULL;
+  h->old_bucket_cnt = 0;
+  h->migrate_idx = 0;
+
+  /* The filter being built for the new buckets is the right size
+     for them. */
+  if (h->next_bloom != NULL)
+    {
+      bitmap_destroy (h->bloom);
+      h->bloom = h->next_bloom;
+      h->next_bloom = NULL;
+    }
+  if (h->bloom != NULL)
+    bitmap_set_all (h->bloom, false);
 
   h->elem_cnt = 0;
 }
@@ -100,6 +356,15 @@ hash_destroy (struct hash *h, hash_action_func *destructor)
   if (destructor != NULL)
     hash_clear (h, destructor);
   free (h->buckets);
+  free (h->old_buckets);
+  bitmap_destroy (h->occupied);
+  bitmap_destroy (h->old_occupied);
+  bitmap_destroy (h->bloom);
+  bitmap_destroy (h->next_bloom);
+  drop_trees (h, &h->trees, h->bucket_cnt);
+  drop_trees (h, &h->old_trees, h->old_bucket_cnt);
+  free (h->ctrl);
+  free (h->slots);
 }
 /*
 , that is, if you want destroy hashtable, then call hash_destroy() func().
@@ -108,18 +373,24 @@ hash_destroy (struct hash *h, hash_action_func *destructor)
 /* Inserts NEW into hash table H and returns a null pointer, if
    no equal element is already in the table.
    If an equal element is already in the table, returns it
-   without inserting NEW. */   
+   without inserting NEW.  If H uses open addressing and memory
+   to grow it is exhausted, returns NEW itself without inserting
+   it. */   
 struct hash_elem *
 hash_insert (struct hash *h, struct hash_elem *new)
 {
-  struct list *bucket = find_bucket (h, new);
-  struct hash_elem *old = find_elem (h, bucket, new);
+  if (h->slots != NULL)
+    return open_insert (h, new, false);
+
+  unsigned hash = seed_hash (h, h->hash (new, h->aux));
+  struct hash_elem **bucket = find_bucket (h, hash);
+  struct hash_elem *old = find_elem (h, bucket, new, NULL, hash, NULL);
   /*
   && duplication is not allowed...
   */
 
   if (old == NULL) 
-    insert_elem (h, bucket, new);
+    insert_elem (h, bucket, new, hash);
 
   rehash (h);
   // If bucket  , ο bucket add...
@@ -131,16 +402,23 @@ hash_insert (struct hash *h, struct hash_elem *new)
 */
 
 /* Inserts NEW into hash table H, replacing any equal element
-   already in the table, which is returned. */
+   already in the table, which is returned.  If H uses open
+   addressing, has no equal element, and memory to grow it is
+   exhausted, returns NEW itself without inserting it. */
 struct hash_elem *
 hash_replace (struct hash *h, struct hash_elem *new) 
 {
-  struct list *bucket = find_bucket (h, new);
-  struct hash_elem *old = find_elem (h, bucket, new);
+  if (h->slots != NULL)
+    return open_insert (h, new, true);
+
+  unsigned hash = seed_hash (h, h->hash (new, h->aux));
+  struct hash_elem **bucket = find_bucket (h, hash);
+  struct hash_elem **link;
+  struct hash_elem *old = find_elem (h, bucket, new, NULL, hash, &link);
 
   if (old != NULL)
-    remove_elem (h, old);
-  insert_elem (h, bucket, new);
+    remove_elem (h, bucket, link);
+  insert_elem (h, bucket, new, hash);
   /* 
   oldElem ٸ, ׳ newElem ߰ϴ ϵ... 
   */
@@ -161,7 +439,69 @@ hash_table[key] = newValue
 struct hash_elem *
 hash_find (struct hash *h, struct hash_elem *e) 
 {
-  return find_elem (h, find_bucket (h, e), e);
+  if (h->slots != NULL)
+    return open_find (h, e, NULL);
+
+  unsigned hash = seed_hash (h, h->hash (e, h->aux));
+  return find_elem (h, find_bucket (h, hash), e, NULL, hash, NULL);
+}
+
+/* Keys looked up together by hash_find_batch(). */
+#define BATCH_WINDOW 16
+
+/* Looks up each of the N elements in KEYS in hash table H, like
+   hash_find(), and stores the element found for KEYS[I], or a
+   null pointer, in OUT[I].
+
+   A lone hash_find() waits for the bucket to arrive from memory
+   and then for the first element in it.  This function instead
+   works through the keys BATCH_WINDOW at a time: it hashes every
+   key of a window and prefetches its bucket, then prefetches the
+   first element of each bucket, and only then searches them, so
+   that the cache misses of different keys overlap. */
+void
+hash_find_batch (struct hash *h, struct hash_elem *keys[], size_t n,
+                 struct hash_elem *out[])
+{
+  unsigned hashes[BATCH_WINDOW];
+  struct hash_elem **buckets[BATCH_WINDOW];
+  size_t base, cnt, i;
+
+  ASSERT (h != NULL);
+  ASSERT (n == 0 || (keys != NULL && out != NULL));
+
+  for (base = 0; base < n; base += cnt)
+    {
+      cnt = n - base < BATCH_WINDOW ? n - base : BATCH_WINDOW;
+
+      for (i = 0; i < cnt; i++)
+        hashes[i] = seed_hash (h, h->hash (keys[base + i], h->aux));
+
+      if (h->slots != NULL)
+        {
+          for (i = 0; i < cnt; i++)
+            {
+              size_t pos = bucket_index (hashes[i], h->bucket_cnt);
+              __builtin_prefetch (h->ctrl + pos);
+              __builtin_prefetch (h->slots + pos);
+            }
+          for (i = 0; i < cnt; i++)
+            out[base + i] = open_lookup (h, hashes[i], keys[base + i], NULL,
+                                         NULL);
+          continue;
+        }
+
+      for (i = 0; i < cnt; i++)
+        {
+          buckets[i] = find_bucket (h, hashes[i]);
+          __builtin_prefetch (buckets[i]);
+        }
+      for (i = 0; i < cnt; i++)
+        __builtin_prefetch (*buckets[i]);
+      for (i = 0; i < cnt; i++)
+        out[base + i] = find_elem (h, buckets[i], keys[base + i], NULL,
+                                   hashes[i], NULL);
+    }
 }
 
 /* Finds, removes, and returns an element equal to E in hash
@@ -174,10 +514,16 @@ hash_find (struct hash *h, struct hash_elem *e)
 struct hash_elem *
 hash_delete (struct hash *h, struct hash_elem *e)
 {
-  struct hash_elem *found = find_elem (h, find_bucket (h, e), e);
+  if (h->slots != NULL)
+    return open_delete (h, e);
+
+  unsigned hash = seed_hash (h, h->hash (e, h->aux));
+  struct hash_elem **bucket = find_bucket (h, hash);
+  struct hash_elem **link;
+  struct hash_elem *found = find_elem (h, bucket, e, NULL, hash, &link);
   if (found != NULL) 
     {
-      remove_elem (h, found);
+      remove_elem (h, bucket, link);
       rehash (h); 
     }
   return found;
@@ -188,6 +534,147 @@ hashtable[key] = value; 
 hashtable[key] = unknown(or NULL); ٽ Reset?...
 */
 
+/* Finds and returns the element of hash table H whose key is
+   KEY, or a null pointer if there is none.  HASH must be the
+   value H's hash function returns for an element with that key,
+   and EQ decides whether an element has it.  Unlike hash_find(),
+   needs no struct hash_elem to search with. */
+struct hash_elem *
+hash_find_key (struct hash *h, const void *key, unsigned hash,
+               hash_key_eq_func *eq)
+{
+  ASSERT (h != NULL);
+  ASSERT (eq != NULL);
+
+  hash = seed_hash (h, hash);
+  if (h->slots != NULL)
+    return open_lookup (h, hash, key, eq, NULL);
+  return find_elem (h, find_bucket (h, hash), key, eq, hash, NULL);
+}
+
+/* Finds, removes, and returns the element of hash table H whose
+   key is KEY, or returns a null pointer if there is none.  KEY,
+   HASH and EQ are as for hash_find_key(), and deallocating the
+   element is up to the caller, as for hash_delete(). */
+struct hash_elem *
+hash_delete_key (struct hash *h, const void *key, unsigned hash,
+                 hash_key_eq_func *eq)
+{
+  struct hash_elem *found;
+
+  ASSERT (h != NULL);
+  ASSERT (eq != NULL);
+
+  hash = seed_hash (h, hash);
+  if (h->slots != NULL)
+    {
+      size_t slot;
+
+      found = open_lookup (h, hash, key, eq, &slot);
+      if (found != NULL)
+        open_remove (h, slot);
+      return found;
+    }
+
+  struct hash_elem **bucket = find_bucket (h, hash);
+  struct hash_elem **link;
+  found = find_elem (h, bucket, key, eq, hash, &link);
+  if (found != NULL)
+    {
+      remove_elem (h, bucket, link);
+      rehash (h);
+    }
+  return found;
+}
+
+/* Returns true if E is KEY itself. */
+static bool
+same_elem (const struct hash_elem *e, const void *key, void *aux UNUSED)
+{
+  return e == key;
+}
+
+/* Removes E, which must be in hash table H, from H.  Where
+   hash_delete() hashes E and searches for an element equal to
+   it, this function uses the hash value cached in E and finds E
+   by comparing pointers, so a caller that already holds the
+   element, such as a cache evicting it, never pays for `hash'.
+   It still calls `less' when E's chain is indexed by a tree, or
+   when the removal migrates old buckets into such a chain,
+   because keeping a tree in order takes comparisons. */
+void
+hash_remove (struct hash *h, struct hash_elem *e)
+{
+  struct hash_elem *found;
+
+  ASSERT (h != NULL);
+  ASSERT (e != NULL);
+
+  if (h->slots != NULL)
+    {
+      size_t slot;
+
+      found = open_lookup (h, e->hash, e, same_elem, &slot);
+      ASSERT (found == e);
+      open_remove (h, slot);
+      return;
+    }
+
+  struct hash_elem **bucket = find_bucket (h, e->hash);
+  struct hash_elem **link;
+  found = find_elem (h, bucket, e, same_elem, e->hash, &link);
+  ASSERT (found == e);
+  remove_elem (h, bucket, link);
+  rehash (h);
+}
+
+/* Makes sure hash table H has an element whose key is KEY, and
+   returns it.  KEY, HASH and EQ are as for hash_find_key().  If
+   there is such an element already, calls UPDATE on it, if
+   UPDATE is non-null.  Otherwise calls MAKE to create one and
+   inserts it; if MAKE returns a null pointer, so does
+   hash_upsert(), and H is left unchanged.  If H uses open
+   addressing and memory to grow it is exhausted, returns a null
+   pointer without calling MAKE.  Either way the table
+   is searched only once, where hash_find() followed by
+   hash_insert() would search it twice.
+
+   UPDATE must not change the element's key.  MAKE and UPDATE
+   are passed H's auxiliary data, and must not call any hash_*()
+   function on H. */
+struct hash_elem *
+hash_upsert (struct hash *h, const void *key, unsigned hash,
+             hash_key_eq_func *eq, hash_make_func *make,
+             hash_action_func *update)
+{
+  struct hash_elem *e;
+
+  ASSERT (h != NULL);
+  ASSERT (eq != NULL);
+  ASSERT (make != NULL);
+
+  hash = seed_hash (h, hash);
+  if (h->slots != NULL)
+    return open_upsert (h, key, hash, eq, make, update);
+
+  struct hash_elem **bucket = find_bucket (h, hash);
+  e = find_elem (h, bucket, key, eq, hash, NULL);
+  if (e != NULL)
+    {
+      if (update != NULL)
+        update (e, h->aux);
+    }
+  else
+    {
+      e = make (key, h->aux);
+      if (e != NULL)
+        insert_elem (h, bucket, e, hash);
+    }
+
+  rehash (h);
+  return e;
+}
+
 /* Calls ACTION for each element in hash table H in arbitrary
    order. 
    Modifying hash table H while hash_apply() is running, using
@@ -197,19 +684,28 @@ hashtable[key] = unknown(or NULL);
 void
 hash_apply (struct hash *h, hash_action_func *action) 
 {
+  struct hash_elem **bucket;
   size_t i;
   
   ASSERT (action != NULL);
 
-  for (i = 0; i < h->bucket_cnt; i++) 
+  if (h->slots != NULL)
+    {
+      for (i = open_next_full (h, 0); i < h->bucket_cnt;
+           i = open_next_full (h, i + 1))
+        action (h->slots[i], h->aux);
+      return;
+    }
+
+  for (bucket = h->old_buckets != NULL ? h->old_buckets : h->buckets;
+       bucket != NULL; bucket = next_bucket (h, bucket))
     {
-      struct list *bucket = &h->buckets[i];
-      struct list_elem *elem, *next;
+      struct hash_elem *elem, *next;
 
-      for (elem = list_begin (bucket); elem != list_end (bucket); elem = next) 
+      for (elem = *bucket; elem != NULL; elem = next) 
         {
-          next = list_next (elem);
-          action (list_elem_to_hash_elem (elem), h->aux);
+          next = elem->next;
+          action (elem, h->aux);
         }
     }
 }
@@ -221,6 +717,189 @@ action
 , hash_apply() : action(eachElem) ==>> doSomething ==>> output will be created...
 */
 
+/* Fewest buckets (or slots) worth handing to a thread of their
+   own in hash_apply_parallel() and hash_reduce_parallel(). */
+#define MIN_SLICE_BUCKETS 4096
+
+/* One thread's share of a parallel walk over a hash table. */
+struct walk_slice
+  {
+    struct hash *h;             /* The hash table. */
+    size_t begin, end;          /* Buckets (or slots) [begin, end). */
+    hash_action_func *action;   /* Called for each element, or... */
+    hash_fold_func *fold;       /* ...folds each element into `acc'. */
+    void *acc;                  /* This share's partial result. */
+    bool threaded;              /* Running on a thread of its own? */
+  };
+
+/* Visits each element in slice S. */
+static void
+walk_slice (struct walk_slice *s)
+{
+  struct hash *h = s->h;
+  size_t i;
+
+  if (h->slots != NULL)
+    {
+      for (i = open_next_full (h, s->begin); i < s->end;
+           i = open_next_full (h, i + 1))
+        if (s->fold != NULL)
+          s->fold (h->slots[i], s->acc, h->aux);
+        else
+          s->action (h->slots[i], h->aux);
+      return;
+    }
+
+  for (i = bitmap_next (h->occupied, s->begin, true);
+       i != BITMAP_ERROR && i < s->end;
+       i = bitmap_next (h->occupied, i + 1, true))
+    {
+      struct hash_elem *elem;
+
+      for (elem = h->buckets[i]; elem != NULL; elem = elem->next)
+        if (s->fold != NULL)
+          s->fold (elem, s->acc, h->aux);
+        else
+          s->action (elem, h->aux);
+    }
+}
+
+/* Thread function for walk_slice(). */
+static void *
+walk_thread (void *s)
+{
+  walk_slice (s);
+  return NULL;
+}
+
+/* Splits H's buckets (or slots) into at most THREAD_CNT slices,
+   0 meaning one per online CPU, and walks them in parallel.  If
+   FOLD is non-null, each slice folds into a copy of the ACC_SIZE
+   bytes at ACC, and the copies are merged back into ACC with
+   MERGE at the end; otherwise each slice calls ACTION.
+
+   Slice 0 runs on the calling thread, as does any slice whose
+   thread cannot be started, so running out of memory or threads
+   only costs parallelism. */
+static void
+walk_parallel (struct hash *h, size_t thread_cnt, hash_action_func *action,
+               hash_fold_func *fold, hash_merge_func *merge,
+               void *acc, size_t acc_size)
+{
+  struct walk_slice *slices;
+  pthread_t *threads;
+  uint8_t *partials = NULL;
+  size_t i;
+
+  /* A pending rehash would leave elements in two arrays. */
+  migrate (h, SIZE_MAX);
+
+  if (thread_cnt == 0)
+    {
+      long cpu_cnt = sysconf (_SC_NPROCESSORS_ONLN);
+      thread_cnt = cpu_cnt > 0 ? (size_t) cpu_cnt : 1;
+    }
+  if (thread_cnt > h->bucket_cnt / MIN_SLICE_BUCKETS)
+    thread_cnt = h->bucket_cnt / MIN_SLICE_BUCKETS;
+  if (thread_cnt == 0)
+    thread_cnt = 1;
+
+  slices = malloc (sizeof *slices * thread_cnt);
+  threads = malloc (sizeof *threads * thread_cnt);
+  if (fold != NULL && thread_cnt > 1)
+    partials = malloc (acc_size * thread_cnt);
+  if (slices == NULL || threads == NULL
+      || (fold != NULL && thread_cnt > 1 && partials == NULL))
+    {
+      struct walk_slice all = { h, 0, h->bucket_cnt, action, fold, acc,
+                                false };
+      walk_slice (&all);
+      goto done;
+    }
+
+  for (i = 0; i < thread_cnt; i++)
+    {
+      struct walk_slice *s = &slices[i];
+
+      s->h = h;
+      s->begin = h->bucket_cnt * i / thread_cnt;
+      s->end = h->bucket_cnt * (i + 1) / thread_cnt;
+      s->action = action;
+      s->fold = fold;
+      s->acc = acc;
+      if (partials != NULL)
+        {
+          s->acc = partials + acc_size * i;
+          memcpy (s->acc, acc, acc_size);
+        }
+      s->threaded = false;
+    }
+
+  for (i = 1; i < thread_cnt; i++)
+    {
+      slices[i].threaded = pthread_create (&threads[i], NULL, walk_thread,
+                                           &slices[i]) == 0;
+      if (!slices[i].threaded)
+        walk_slice (&slices[i]);
+    }
+  walk_slice (&slices[0]);
+  for (i = 1; i < thread_cnt; i++)
+    if (slices[i].threaded)
+      pthread_join (threads[i], NULL);
+
+  if (partials != NULL)
+    for (i = 0; i < thread_cnt; i++)
+      merge (acc, slices[i].acc, h->aux);
+
+ done:
+  free (slices);
+  free (threads);
+  free (partials);
+}
+
+/* Calls ACTION for each element in hash table H, like
+   hash_apply(), but splits the table among up to THREAD_CNT
+   threads (0 means one per online CPU).  Small tables are walked
+   on the calling thread alone.
+
+   ACTION runs on several threads at once, each given different
+   elements.  It may modify the element it is given, but nothing
+   shared with other calls (AUX included) without its own
+   synchronization, and it must not call any hash_*() function on
+   H.  As with hash_apply(), an element whose hash value ACTION
+   changes stays where it was, so it can no longer be found.
+   Any pending incremental rehash of H is finished first. */
+void
+hash_apply_parallel (struct hash *h, size_t thread_cnt,
+                     hash_action_func *action)
+{
+  ASSERT (action != NULL);
+
+  walk_parallel (h, thread_cnt, action, NULL, NULL, NULL, 0);
+}
+
+/* Reduces the elements of hash table H into *ACC, an object of
+   ACC_SIZE bytes, using up to THREAD_CNT threads as
+   hash_apply_parallel() does.  Each thread starts from a copy of
+   *ACC, calls FOLD to fold each of its elements into that copy,
+   and at the end each copy is merged into *ACC with MERGE.  *ACC
+   must therefore start out as the identity of MERGE: 0 for a sum
+   or a count, the largest value for a minimum, and so on.
+
+   FOLD must not modify the elements, and FOLD and MERGE are
+   subject to the same rules as hash_apply_parallel()'s ACTION. */
+void
+hash_reduce_parallel (struct hash *h, size_t thread_cnt,
+                      hash_fold_func *fold, hash_merge_func *merge,
+                      void *acc, size_t acc_size)
+{
+  ASSERT (fold != NULL);
+  ASSERT (merge != NULL);
+  ASSERT (acc != NULL);
+
+  walk_parallel (h, thread_cnt, NULL, fold, merge, acc, acc_size);
+}
+
 /* Initializes I for iterating hash table H.
 
    Iteration idiom:
@@ -246,8 +925,16 @@ hash_first (struct hash_iterator *i, struct hash *h)
   ASSERT (h != NULL);
 
   i->hash = h;
-  i->bucket = i->hash->buckets; // bucket means eachBucket?...
-  i->elem = list_elem_to_hash_elem (list_head (i->bucket));
+  if (h->slots != NULL)
+    {
+      /* Just before slot 0: hash_next() adds 1, wrapping to 0. */
+      i->bucket = NULL;
+      i->elem = NULL;
+      i->slot = (size_t) -1;
+      return;
+    }
+  i->bucket = h->old_buckets != NULL ? h->old_buckets : h->buckets;
+  i->elem = NULL;
 }
 
 /* Advances I to the next element in the hash table and returns
@@ -263,16 +950,24 @@ hash_next (struct hash_iterator *i)
 {
   ASSERT (i != NULL);
 
-  i->elem = list_elem_to_hash_elem (list_next (&i->elem->list_elem));
-  while (i->elem == list_elem_to_hash_elem (list_end (i->bucket))) // eachBucket end ߴٸ,  bucket Ѿ ...
+  if (i->hash->slots != NULL)
     {
-      // If iterator reach end?, then i->elem = NULL; ְ, NULL returnϵ ó...
-      if (++i->bucket >= i->hash->buckets + i->hash->bucket_cnt)
-        {
-          i->elem = NULL;
-          break;
-        }
-      i->elem = list_elem_to_hash_elem (list_begin (i->bucket));
+      i->slot = open_next_full (i->hash, i->slot + 1);
+      i->elem = i->slot < i->hash->bucket_cnt ? i->hash->slots[i->slot] : NULL;
+      return i->elem;
+    }
+
+  if (i->bucket == NULL)
+    return NULL;
+  /* A null element, right after hash_first(), is just before the
+     first bucket's chain. */
+  i->elem = i->elem != NULL ? i->elem->next : *i->bucket;
+  while (i->elem == NULL)
+    {
+      i->bucket = next_bucket (i->hash, i->bucket);
+      if (i->bucket == NULL)
+        break;
+      i->elem = *i->bucket;
     }
   
   return i->elem;
@@ -289,6 +984,157 @@ hash_cur (struct hash_iterator *i)
   //  returnValue ̿Ͽ, value س  ?...
 }
 
+/* Makes room in H for at least ELEM_CNT elements in all, so that
+   inserting up to that many does not resize it, and keeps H from
+   shrinking below that size until hash_shrink_to_fit() is
+   called.  Use it before a bulk load, to skip the resizes the
+   table would otherwise go through on the way up.  Any rehash in
+   progress is finished first.  Returns false if memory is
+   exhausted, in which case H is still usable. */
+bool
+hash_reserve (struct hash *h, size_t elem_cnt)
+{
+  size_t bucket_cnt;
+
+  ASSERT (h != NULL);
+
+  if (h->slots != NULL)
+    return open_reserve (h, elem_cnt);
+
+  migrate (h, SIZE_MAX);
+  bucket_cnt = best_bucket_cnt (elem_cnt);
+  if (bucket_cnt > h->bucket_cnt)
+    {
+      if (!start_rehash (h, bucket_cnt))
+        return false;
+      migrate (h, SIZE_MAX);
+    }
+  if (bucket_cnt > h->min_bucket_cnt)
+    h->min_bucket_cnt = bucket_cnt;
+  return true;
+}
+
+/* Undoes any hash_reserve() on H and shrinks it to the size
+   best suited to the elements it holds now, if that is
+   smaller. */
+void
+hash_shrink_to_fit (struct hash *h)
+{
+  size_t bucket_cnt;
+
+  ASSERT (h != NULL);
+
+  if (h->slots != NULL)
+    {
+      open_shrink_to_fit (h);
+      return;
+    }
+
+  migrate (h, SIZE_MAX);
+  h->min_bucket_cnt = MIN_BUCKET_CNT;
+  bucket_cnt = best_bucket_cnt (h->elem_cnt);
+  if (bucket_cnt < h->bucket_cnt && start_rehash (h, bucket_cnt))
+    migrate (h, SIZE_MAX);
+}
+
+/* Writes the value of every element of H, in arbitrary order, to
+   snapshot file FILE_NAME (see snapshot.h), replacing any file
+   of that name.  Returns false if the file cannot be written. */
+bool
+hash_save (struct hash *h, const char *file_name)
+{
+  struct snapshot_writer w;
+  struct hash_iterator i;
+
+  ASSERT (h != NULL);
+
+  if (!snapshot_create (&w, file_name, h->elem_cnt))
+    return false;
+  hash_first (&i, h);
+  while (hash_next (&i))
+    snapshot_put (&w, hash_cur (&i)->value);
+  return snapshot_finish (&w);
+}
+
+/* Fills H, which must be empty, from snapshot file FILE_NAME
+   written by hash_save().  MAKE is called with a pointer to each
+   value, as by hash_upsert(), to create its element.
+
+   The file is mapped rather than read, and H is sized for all of
+   its values before the first one goes in, so loading never
+   resizes H.  hash_save() writes each value once, but the header
+   check in snapshot_map() cannot tell a file that repeats values,
+   being hand-edited, concatenated or corrupt, from one that does
+   not, so each value is looked up before its element is made and
+   placed; a repeat is skipped, as int_set_load() skips it.
+
+   Returns false if the file cannot be mapped, is not a valid
+   snapshot, or memory is exhausted.  H may then hold some of the
+   values, for the caller to clear. */
+bool
+hash_load (struct hash *h, const char *file_name, hash_make_func *make)
+{
+  struct snapshot snap;
+  size_t min_bucket_cnt;
+  bool ok = true;
+  size_t i;
+
+  ASSERT (h != NULL);
+  ASSERT (make != NULL);
+  ASSERT (hash_empty (h));
+
+  if (!snapshot_map (&snap, file_name))
+    return false;
+
+  /* Reserve without pinning the size: once loaded, H may shrink
+     again as if it had been built one insertion at a time. */
+  min_bucket_cnt = h->min_bucket_cnt;
+  if (!hash_reserve (h, snap.value_cnt))
+    {
+      snapshot_unmap (&snap);
+      return false;
+    }
+  h->min_bucket_cnt = min_bucket_cnt;
+
+  for (i = 0; i < snap.value_cnt; i++)
+    {
+      struct hash_elem probe, *e;
+      struct hash_elem **bucket = NULL;
+      unsigned hash;
+
+      /* A probe with the value stands in for the element until
+         the value is known to be new. */
+      probe.next = NULL;
+      probe.value = snap.values[i];
+      hash = seed_hash (h, h->hash (&probe, h->aux));
+      if (h->slots != NULL)
+        {
+          if (open_lookup (h, hash, &probe, NULL, NULL) != NULL)
+            continue;
+        }
+      else
+        {
+          bucket = find_bucket (h, hash);
+          if (find_elem (h, bucket, &probe, NULL, hash, NULL) != NULL)
+            continue;
+        }
+
+      e = make (&probe.value, h->aux);
+      if (e == NULL)
+        {
+          ok = false;
+          break;
+        }
+      if (h->slots != NULL)
+        open_place (h, hash, e);
+      else
+        insert_elem (h, bucket, e, hash);
+    }
+
+  snapshot_unmap (&snap);
+  return ok;
+}
+
 /* Returns the number of elements in H. */
 size_t
 hash_size (struct hash *h) 
@@ -306,43 +1152,150 @@ hash_empty (struct hash *h)
   return h->elem_cnt == 0;
 } /* Is hashtable empty?...*/
 
-/* Fowler-Noll-Vo hash constants, for 32-bit word sizes. */
-#define FNV_32_PRIME 16777619u
-#define FNV_32_BASIS 2166136261u
-
-/* Returns a hash of the SIZE bytes in BUF. */
-unsigned
-hash_bytes (const void *buf_, size_t size)
+/* Stores in *ST a snapshot of H's size, counters, and chain
+   lengths.  Takes time proportional to the size of H. */
+void
+hash_stats (struct hash *h, struct hash_stats *st)
 {
-  /* Fowler-Noll-Vo 32-bit hash, for bytes. */
-  const unsigned char *buf = buf_;
-  unsigned hash;
+  size_t nonempty_cnt = 0;
+  size_t chain_sum = 0;
+  size_t i;
 
-  ASSERT (buf != NULL);
+  ASSERT (h != NULL);
+  ASSERT (st != NULL);
+
+  memset (st, 0, sizeof *st);
+  st->elem_cnt = h->elem_cnt;
+  st->bucket_cnt = h->bucket_cnt + h->old_bucket_cnt - h->migrate_idx;
+  st->load_factor = (double) st->elem_cnt / st->bucket_cnt;
+  st->rehash_cnt = h->rehash_cnt;
+  st->rehash_ns = h->rehash_ns;
+  st->lookup_cnt = h->lookup_cnt;
+  st->probe_cnt = h->probe_cnt;
+  st->bloom_bit_cnt = h->bloom != NULL ? bitmap_size (h->bloom) : 0;
+  st->bloom_neg_cnt = h->bloom_neg_cnt;
+  st->bloom_fp_cnt = h->bloom_fp_cnt;
+  st->tree_cnt = h->tree_cnt;
+
+  if (h->slots != NULL)
+    for (i = open_next_full (h, 0); i < h->bucket_cnt;
+         i = open_next_full (h, i + 1))
+      {
+        size_t len = open_chain_len (h, i);
+
+        st->chain_hist[len < HASH_STATS_HIST ? len : HASH_STATS_HIST - 1]++;
+        if (len > st->max_chain)
+          st->max_chain = len;
+        nonempty_cnt++;
+        chain_sum += len;
+      }
+  else
+    {
+      struct hash_elem **bucket;
+
+      /* Old buckets already migrated are gone, in effect.
+         next_bucket() skips the empty buckets, which are all
+         counted at the end. */
+      for (bucket = (h->old_buckets != NULL
+                     ? h->old_buckets + h->migrate_idx : h->buckets);
+           bucket != NULL; bucket = next_bucket (h, bucket))
+        {
+          struct hash_elem *e;
+          size_t len = 0;
+
+          for (e = *bucket; e != NULL; e = e->next)
+            len++;
+          if (len == 0)
+            continue;
+          st->chain_hist[len < HASH_STATS_HIST ? len : HASH_STATS_HIST - 1]++;
+          if (len > st->max_chain)
+            st->max_chain = len;
+          nonempty_cnt++;
+          chain_sum += len;
+        }
+      st->chain_hist[0] = st->bucket_cnt - nonempty_cnt;
+    }
 
-  hash = FNV_32_BASIS;
-  while (size-- > 0)
-    hash = (hash * FNV_32_PRIME) ^ *buf++;
+  if (nonempty_cnt > 0)
+    st->mean_chain = (double) chain_sum / nonempty_cnt;
+}
 
-  return hash;
-} 
-// Maybe..., 
-// inputBuf with Size = size ~~>> hash_bytes() is executed ~~>> hashValue...
+/* 2**64 divided by the golden ratio.  Multiplying by it spreads
+   the low bits of a word over the high ones; see also
+   bucket_index(). */
+#define GOLDEN_64 0x9e3779b97f4a7c15ull
 
-/* Returns a hash of string S. */
-unsigned
-hash_string (const char *s_) 
+/* Returns X with its bits mixed so that flipping any input bit
+   flips each output bit with probability close to 1/2.  This is
+   the 32-bit finalizer of MurmurHash3. */
+static inline unsigned
+fmix32 (uint32_t x)
 {
-  const unsigned char *s = (const unsigned char *) s_;
-  unsigned hash;
+  x ^= x >> 16;
+  x *= 0x85ebca6bu;
+  x ^= x >> 13;
+  x *= 0xc2b2ae35u;
+  x ^= x >> 16;
+  return x;
+}
 
-  ASSERT (s != NULL);
+/* Like fmix32(), for 64-bit values (MurmurHash3's 64-bit
+   finalizer). */
+static inline uint64_t
+fmix64 (uint64_t x)
+{
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdull;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ull;
+  x ^= x >> 33;
+  return x;
+}
+
+/* Folds the 8-byte WORD into running hash HASH. */
+static inline uint64_t
+fold_word (uint64_t hash, uint64_t word)
+{
+  hash = (hash ^ word) * GOLDEN_64;
+  return hash ^ (hash >> 29);
+}
+
+/* Returns a hash of the SIZE bytes in BUF. */
+unsigned
+hash_bytes (const void *buf_, size_t size)
+{
+  /* Reads BUF a word at a time rather than a byte at a time,
+     and mixes the state fully only once, at the end. */
+  const unsigned char *buf = buf_;
+  uint64_t hash, word;
+
+  ASSERT (buf != NULL);
+
+  hash = GOLDEN_64 ^ size;
+  for (; size >= sizeof word; buf += sizeof word, size -= sizeof word)
+    {
+      memcpy (&word, buf, sizeof word);
+      hash = fold_word (hash, word);
+    }
+  if (size > 0)
+    {
+      word = 0;
+      memcpy (&word, buf, size);
+      hash = fold_word (hash, word);
+    }
+
+  return fmix64 (hash);
+} 
+// Maybe..., 
+// inputBuf with Size = size ~~>> hash_bytes() is executed ~~>> hashValue...
 
-  hash = FNV_32_BASIS;
-  while (*s != '\0')
-    hash = (hash * FNV_32_PRIME) ^ *s++;
+/* Returns a hash of string S. */
+unsigned
+hash_string (const char *s) 
+{
+  ASSERT (s != NULL);
 
-  return hash;
+  return hash_bytes (s, strlen (s));
 }
 /*
 , inputString ~~>> hash_string() ~~>> hashValue...
@@ -352,12 +1305,19 @@ hash_string (const char *s_)
 unsigned
 hash_int (int i) 
 {
-  return hash_bytes (&i, sizeof i);
+  return fmix32 (i);
 }
 /*
 ̰, ׳ int ~~>> hash_int() is executed... ~~>> hashValue... 
 */
 
+/* Returns a hash of 64-bit integer X. */
+unsigned
+hash_u64 (uint64_t x)
+{
+  return fmix64 (x);
+}
+
 // ---.
 
 unsigned int hash_int_2(int i) {
@@ -383,36 +1343,204 @@ A. "key ~~>> bucketID(or hashValue)" ~~>> value.
 
 // ---.
 
-/* Returns the bucket in H that E belongs in. */
-static struct list *
-find_bucket (struct hash *h, struct hash_elem *e) 
+/* Returns true if A and B are equal according to H. */
+static inline bool
+elem_equal (struct hash *h, struct hash_elem *a, struct hash_elem *b)
 {
-  size_t bucket_idx = h->hash (e, h->aux) & (h->bucket_cnt - 1);
-  return &h->buckets[bucket_idx];
+  if (h->eq != NULL)
+    return h->eq (a, b, h->aux);
+  return !h->less (a, b, h->aux) && !h->less (b, a, h->aux);
+}
+
+/* Returns true if element E of H matches KEY.  For the key-based
+   functions, KEY_EQ is non-null and decides.  Otherwise KEY is a
+   struct hash_elem, compared with elem_equal(). */
+static inline bool
+elem_matches (struct hash *h, struct hash_elem *e, const void *key,
+              hash_key_eq_func *key_eq)
+{
+  if (key_eq != NULL)
+    return key_eq (e, key, h->aux);
+  return elem_equal (h, e, (struct hash_elem *) key);
+}
+
+/* Returns the index, among BUCKET_CNT buckets, of the bucket for
+   hash value HASH.  This is Fibonacci hashing: HASH is
+   multiplied by 2**64 divided by the golden ratio and the top
+   bits of the product are kept, so every bit of HASH affects the
+   index, not just the low ones as with HASH & (BUCKET_CNT - 1).
+   A hash function whose low bits vary little, such as the
+   identity on multiples of 16, still spreads over all buckets.
+   BUCKET_CNT must be a power of 2. */
+static inline size_t
+bucket_index (unsigned hash, size_t bucket_cnt)
+{
+  int shift = 64 - __builtin_ctzll (bucket_cnt);
+
+  return shift < 64 ? (hash * GOLDEN_64) >> shift : 0;
+}
+
+/* Counts one search of H that examined PROBE_CNT chain nodes or
+   groups, if H counts searches (see hash_set_stats()).
+   hash_find() may run in several threads at once (see chash.h),
+   so the counters are updated with relaxed atomic loads and
+   stores: never torn, but concurrent updates may be lost, which
+   is fine for statistics and costs no more than plain
+   increments. */
+static inline void
+count_lookup (struct hash *h, size_t probe_cnt)
+{
+  if (!h->count_searches)
+    return;
+  __atomic_store_n (&h->lookup_cnt,
+                    __atomic_load_n (&h->lookup_cnt, __ATOMIC_RELAXED) + 1,
+                    __ATOMIC_RELAXED);
+  __atomic_store_n (&h->probe_cnt,
+                    __atomic_load_n (&h->probe_cnt, __ATOMIC_RELAXED)
+                    + probe_cnt, __ATOMIC_RELAXED);
+}
+
+/* Returns the current time in nanoseconds, for rehash_ns. */
+static uint64_t
+now_ns (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* Returns the time of a coarse clock in nanoseconds, for timing
+   migrate().  It costs less to read than now_ns()'s clock but
+   only advances once a tick, every few milliseconds: a step that
+   falls between two ticks counts as 0 and one that spans a tick
+   counts the whole tick, which adds up to the right total over
+   the many steps of a resize. */
+static uint64_t
+coarse_ns (void)
+{
+  struct timespec ts;
+
+#ifdef CLOCK_MONOTONIC_COARSE
+  clock_gettime (CLOCK_MONOTONIC_COARSE, &ts);
+#else
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+#endif
+  return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* Returns the bucket in H that elements with hash value HASH
+   belong in.  While a rehash is in progress, that is their
+   bucket in the old array if it has not been migrated yet, and
+   their bucket in the new array otherwise, so a lookup still
+   searches only one chain. */
+static struct hash_elem **
+find_bucket (struct hash *h, unsigned hash) 
+{
+  if (h->old_buckets != NULL)
+    {
+      size_t old_idx = bucket_index (hash, h->old_bucket_cnt);
+      if (old_idx >= h->migrate_idx)
+        return &h->old_buckets[old_idx];
+    }
+  return &h->buckets[bucket_index (hash, h->bucket_cnt)];
 }
 /*
 , struct hash_elem* e  bucket ...
 */
 
-/* Searches BUCKET in H for a hash element equal to E.  Returns
-   it if found or a null pointer otherwise. */
+/* Searches BUCKET in H for the element KEY, whose hash value is
+   HASH (see elem_matches()).  Returns it if found or a null
+   pointer otherwise.  Elements whose cached hash differs cannot
+   match, so they are skipped without calling `less'.  If LINK is
+   non-null and the element is found, stores in *LINK the pointer
+   to it in the chain, the bucket's head or the previous
+   element's `next', for remove_elem(). */
 static struct hash_elem *
-find_elem (struct hash *h, struct list *bucket, struct hash_elem *e) 
+find_elem (struct hash *h, struct hash_elem **bucket, const void *key,
+           hash_key_eq_func *key_eq, unsigned hash, struct hash_elem ***link)
 {
-  struct list_elem *i;
+  struct hash_tree **tree = tree_slot (h, bucket);
+  struct hash_elem *found = NULL;
+  struct hash_elem **i;
+  size_t probe_cnt = 0;
 
-  for (i = list_begin (bucket); i != list_end (bucket); i = list_next (i)) 
+  if (h->bloom != NULL && !bloom_test (h->bloom, hash))
     {
-      struct hash_elem *hi = list_elem_to_hash_elem (i);
-      if (!h->less (hi, e, h->aux) && !h->less (e, hi, h->aux))
-        return hi; 
+      count_bloom (h, &h->bloom_neg_cnt);
+      count_lookup (h, 0);
+      return NULL;
     }
-  return NULL;
+
+  if (tree != NULL && *tree != NULL)
+    {
+      found = tree_find (*tree, key, key_eq, hash, h->aux, &probe_cnt);
+      if (found != NULL && link != NULL)
+        *link = tree_link (*tree, bucket, found);
+    }
+  else
+    for (i = bucket; *i != NULL; i = &(*i)->next) 
+      {
+        struct hash_elem *hi = *i;
+        probe_cnt++;
+        if (hi->hash == hash && elem_matches (h, hi, key, key_eq))
+          {
+            found = hi;
+            if (link != NULL)
+              *link = i;
+            break;
+          }
+      }
+  if (found == NULL && h->bloom != NULL)
+    count_bloom (h, &h->bloom_fp_cnt);
+  count_lookup (h, probe_cnt);
+  return found;
 }
 /*
 Parameter  bucket ŽϿ, Parameter  struct hash_elem* e ϴ  Checking...
 */
 
+/* Returns true if BUCKET is one of H's old buckets, awaiting
+   migration, rather than one of its new ones. */
+static inline bool
+is_old_bucket (struct hash *h, struct hash_elem **bucket)
+{
+  return (h->old_buckets != NULL && bucket >= h->old_buckets
+          && bucket < h->old_buckets + h->old_bucket_cnt);
+}
+
+/* Returns the first non-empty bucket that follows BUCKET in H,
+   visiting the buckets awaiting migration before the new ones,
+   or a null pointer after the last one.  The occupancy bitmaps
+   let it skip runs of empty buckets a word at a time. */
+static struct hash_elem **
+next_bucket (struct hash *h, struct hash_elem **bucket)
+{
+  size_t idx;
+
+  if (is_old_bucket (h, bucket))
+    {
+      idx = bitmap_next (h->old_occupied, bucket - h->old_buckets + 1, true);
+      if (idx != BITMAP_ERROR)
+        return &h->old_buckets[idx];
+      idx = bitmap_next (h->occupied, 0, true);
+    }
+  else
+    idx = bitmap_next (h->occupied, bucket - h->buckets + 1, true);
+  return idx != BITMAP_ERROR ? &h->buckets[idx] : NULL;
+}
+
+/* Records in H's occupancy bitmaps whether BUCKET, old or new,
+   holds any elements. */
+static void
+set_occupied (struct hash *h, struct hash_elem **bucket, bool occupied)
+{
+  if (is_old_bucket (h, bucket))
+    bitmap_set (h->old_occupied, bucket - h->old_buckets, occupied);
+  else
+    bitmap_set (h->occupied, bucket - h->buckets, occupied);
+}
+
 /* Returns X with its lowest-order bit set to 1 turned off. */
 static inline size_t
 turn_off_least_1bit (size_t x) 
@@ -432,6 +1560,10 @@ is_power_of_2 (size_t x)
 #define BEST_ELEMS_PER_BUCKET 2 /* Ideal elems/bucket. */
 #define MAX_ELEMS_PER_BUCKET  4 /* Elems/bucket > 4: increase # of buckets. */
 
+/* Old buckets migrated by each insertion, replacement, or
+   deletion while a rehash is in progress. */
+#define MIGRATE_BUCKETS 4
+
 /* Changes the number of buckets in hash table H to match the
    ideal(̻̰?...).  This function can fail because of an out-of-memory
    condition, but that'll just make hash accesses less efficient;
@@ -439,87 +1571,1031 @@ is_power_of_2 (size_t x)
 static void
 rehash (struct hash *h) 
 {
-  size_t old_bucket_cnt, new_bucket_cnt;
-  struct list *new_buckets, *old_buckets;
-  size_t i;
+  size_t new_bucket_cnt;
 
   ASSERT (h != NULL);
 
-  /* Save old bucket info for later use. */
-  old_buckets = h->buckets;
-  old_bucket_cnt = h->bucket_cnt;
+  /* Finish one rehash before starting the next. */
+  if (h->old_buckets != NULL)
+    {
+      migrate (h, MIGRATE_BUCKETS);
+      return;
+    }
 
   /* Calculate the number of buckets to use now.
-     We want one bucket for about every BEST_ELEMS_PER_BUCKET.
-     We must have at least four buckets, and the number of
-     buckets must be a power of 2. */
-  new_bucket_cnt = h->elem_cnt / BEST_ELEMS_PER_BUCKET;
-  if (new_bucket_cnt < 4)
-    new_bucket_cnt = 4;
-  while (!is_power_of_2 (new_bucket_cnt))
-    new_bucket_cnt = turn_off_least_1bit (new_bucket_cnt);
+     Grow only above MAX_ELEMS_PER_BUCKET and shrink only below
+     MIN_ELEMS_PER_BUCKET, doubling or halving until the load is
+     back between the two, which leaves it near
+     BEST_ELEMS_PER_BUCKET.  The gap between the thresholds keeps
+     a table whose size hovers around a boundary from resizing
+     back and forth.  We must keep at least MIN_BUCKET_CNT
+     buckets, or as many as hash_reserve() asked for, and the
+     number of buckets must be a power of 2. */
+  new_bucket_cnt = h->bucket_cnt;
+  while (h->elem_cnt > new_bucket_cnt * MAX_ELEMS_PER_BUCKET)
+    new_bucket_cnt *= 2;
+  while (new_bucket_cnt / 2 >= h->min_bucket_cnt
+         && h->elem_cnt < new_bucket_cnt * MIN_ELEMS_PER_BUCKET)
+    new_bucket_cnt /= 2;
 
   /* Don't do anything if the bucket count wouldn't change. */
-  if (new_bucket_cnt == old_bucket_cnt)
+  if (new_bucket_cnt == h->bucket_cnt)
     return;
 
-  /* Allocate new buckets and initialize them as empty. */
-  new_buckets = malloc (sizeof *new_buckets * new_bucket_cnt);
-  if (new_buckets == NULL) 
+  if (start_rehash (h, new_bucket_cnt))
+    migrate (h, MIGRATE_BUCKETS);
+}
+
+/* Returns the number of buckets best suited to ELEM_CNT
+   elements: the smallest power of 2, no less than
+   MIN_BUCKET_CNT, with at most BEST_ELEMS_PER_BUCKET elements
+   per bucket. */
+static size_t
+best_bucket_cnt (size_t elem_cnt)
+{
+  size_t bucket_cnt = MIN_BUCKET_CNT;
+
+  while (bucket_cnt * BEST_ELEMS_PER_BUCKET < elem_cnt)
+    bucket_cnt *= 2;
+  return bucket_cnt;
+}
+
+/* Gives H a new, empty array of BUCKET_CNT buckets, a power of
+   2, and makes its current buckets the ones to migrate.  No
+   rehash may be in progress.  Returns false, leaving H as it
+   was, if memory is exhausted.  That only makes use of the hash
+   table less efficient; it is still usable. */
+static bool
+start_rehash (struct hash *h, size_t bucket_cnt)
+{
+  struct hash_elem **new_buckets;
+  struct bitmap *new_occupied;
+  struct bitmap *new_bloom = NULL;
+  uint64_t start = now_ns ();
+
+  ASSERT (h->old_buckets == NULL);
+  ASSERT (is_power_of_2 (bucket_cnt));
+
+  /* Allocate new buckets and initialize them as empty.  A Bloom
+     filter is rebuilt for the new size as elements migrate, and
+     meanwhile the old one, which covers them all, stays in use. */
+  new_buckets = calloc (bucket_cnt, sizeof *new_buckets);
+  new_occupied = bitmap_create (bucket_cnt);
+  if (h->bloom != NULL)
+    new_bloom = bitmap_create (bloom_bit_cnt (bucket_cnt));
+  if (new_buckets == NULL || new_occupied == NULL
+      || (h->bloom != NULL && new_bloom == NULL))
     {
-      /* Allocation failed.  This means that use of the hash table will
-         be less efficient.  However, it is still usable, so
-         there's no reason for it to be an error. */
-      return;
+      free (new_buckets);
+      bitmap_destroy (new_occupied);
+      bitmap_destroy (new_bloom);
+      return false;
     }
-  for (i = 0; i < new_bucket_cnt; i++) 
-    list_init (&new_buckets[i]);
-
-  /* Install new bucket info. */
+  h->rehash_cnt++;
+
+  /* Install new bucket info, keeping the old buckets until all
+     their elements have been migrated. */
+  h->old_buckets = h->buckets;
+  h->old_occupied = h->occupied;
+  h->old_trees = h->trees;
+  h->trees = NULL;
+  h->old_bucket_cnt = h->bucket_cnt;
+  h->migrate_idx = 0;
   h->buckets = new_buckets;
-  h->bucket_cnt = new_bucket_cnt;
+  h->occupied = new_occupied;
+  h->next_bloom = new_bloom;
+  h->bucket_cnt = bucket_cnt;
+  h->rehash_ns += now_ns () - start;
+  return true;
+}
 
-  /* Move each old element into the appropriate new bucket. */
-  for (i = 0; i < old_bucket_cnt; i++) 
+/* Moves the elements of up to BUCKET_CNT more old buckets of H
+   into the new ones, and frees the old array once it is empty.
+
+   Resizing all at once would make the one insertion or deletion
+   that triggers it take time proportional to the size of the
+   table.  Instead, rehash() leaves both arrays in place and each
+   later insertion, replacement, or deletion migrates a few old
+   buckets, in index order.  Old buckets below MIGRATE_IDX are
+   empty; find_bucket() relies on that.  Each call is timed with
+   coarse_ns(), whose clock is cheap enough to read on every
+   step. */
+static void
+migrate (struct hash *h, size_t bucket_cnt)
+{
+  uint64_t start;
+
+  if (h->old_buckets == NULL)
+    return;
+
+  start = coarse_ns ();
+  while (bucket_cnt-- > 0 && h->migrate_idx < h->old_bucket_cnt)
     {
-      struct list *old_bucket;
-      struct list_elem *elem, *next;
+      struct hash_elem **old_bucket = &h->old_buckets[h->migrate_idx];
 
-      old_bucket = &old_buckets[i];
-      for (elem = list_begin (old_bucket);
-           elem != list_end (old_bucket); elem = next) 
+      /* The chain scatters, so its tree, if any, is no use. */
+      if (h->old_trees != NULL && h->old_trees[h->migrate_idx] != NULL)
+        drop_tree (h, &h->old_trees[h->migrate_idx]);
+      bitmap_reset (h->old_occupied, h->migrate_idx++);
+      while (*old_bucket != NULL)
         {
-          struct list *new_bucket
-            = find_bucket (h, list_elem_to_hash_elem (elem));
-          next = list_next (elem);
-          list_remove (elem);
-          list_push_front (new_bucket, elem);
+          struct hash_elem *elem = *old_bucket;
+          size_t idx = bucket_index (elem->hash, h->bucket_cnt);
+
+          *old_bucket = elem->next;
+          link_elem (h, &h->buckets[idx], elem);
+          bitmap_mark (h->occupied, idx);
+          if (h->next_bloom != NULL)
+            bloom_add (h->next_bloom, elem->hash);
         }
     }
 
-  free (old_buckets);
+  if (h->migrate_idx == h->old_bucket_cnt)
+    {
+      free (h->old_buckets);
+      bitmap_destroy (h->old_occupied);
+      free (h->old_trees);
+      h->old_trees = NULL;
+      h->old_buckets = NULL;
+      h->old_occupied = NULL;
+      h->old_bucket_cnt = 0;
+      h->migrate_idx = 0;
+
+      /* The new filter now covers every element, and none that
+         were deleted before they could migrate. */
+      if (h->next_bloom != NULL)
+        {
+          bitmap_destroy (h->bloom);
+          h->bloom = h->next_bloom;
+          h->next_bloom = NULL;
+        }
+    }
+  h->rehash_ns += coarse_ns () - start;
 }
 
-/* Inserts E into BUCKET (in hash table H). */
+/* Inserts E, whose hash value is HASH, into BUCKET (in hash
+   table H). */
 static void
-insert_elem (struct hash *h, struct list *bucket, struct hash_elem *e) 
+insert_elem (struct hash *h, struct hash_elem **bucket, struct hash_elem *e,
+             unsigned hash) 
 {
+  e->hash = hash;
   h->elem_cnt++;
-  list_push_front (bucket, &e->list_elem);
+  if (*bucket == NULL)
+    set_occupied (h, bucket, true);
+  link_elem (h, bucket, e);
+  if (h->bloom != NULL)
+    bloom_add (h->bloom, hash);
+  if (h->next_bloom != NULL)
+    bloom_add (h->next_bloom, hash);
+}
+
+/* Links E, whose hash is cached, into the chain of BUCKET in H:
+   at the front, or in tree order if the chain has a tree (see
+   below), in which case E goes into the tree too.  Gives a chain
+   that grows too long a tree. */
+static void
+link_elem (struct hash *h, struct hash_elem **bucket, struct hash_elem *e)
+{
+  struct hash_tree **tree = tree_slot (h, bucket);
+  struct hash_elem **link = bucket;
+
+  if (tree != NULL && *tree != NULL)
+    {
+      e->next = NULL;           /* Not a probe (see probe_key()). */
+      if (btree_insert (&(*tree)->tree, hash_to_btree_elem (e)) == NULL)
+        link = tree_link (*tree, bucket, e);
+      else
+        drop_tree (h, tree);
+    }
+  e->next = *link;
+  *link = e;
+  if ((tree == NULL || *tree == NULL)
+      && chain_longer_than (*bucket, TREEIFY_LEN))
+    treeify (h, bucket);
 }
 /*
 , ش bucket Elem Inserting...
 */
 
-/* Removes E from hash table H. */
+/* Removes the element *LINK points to, as find_elem() found it,
+   from BUCKET in hash table H. */
 static void
-remove_elem (struct hash *h, struct hash_elem *e) 
+remove_elem (struct hash *h, struct hash_elem **bucket,
+             struct hash_elem **link) 
 {
+  struct hash_tree **tree = tree_slot (h, bucket);
+  struct hash_elem *e = *link;
+
+  if (tree != NULL && *tree != NULL)
+    {
+      btree_delete (&(*tree)->tree, hash_to_btree_elem (e));
+      if (btree_size (&(*tree)->tree) < UNTREEIFY_LEN)
+        drop_tree (h, tree);
+    }
+
   h->elem_cnt--;
-  list_remove (&e->list_elem);
+  *link = e->next;
+  if (*bucket == NULL)
+    set_occupied (h, bucket, false);
 }
 /*
 , Parameter  struct hash_elem* e Removing...
 */
 
 // Wait a minute...
+
+/* Seeding.
+
+   An unseeded table sends the same keys to the same buckets every
+   time, so keys chosen to collide once collide always.  Each
+   table therefore mixes every hash value it gets, before using
+   it for anything, with a seed of its own: fmix64() of the value
+   XORed with the seed.  The seeds derive from a random secret
+   drawn once per process, so they cannot be predicted from
+   outside.  This is not a cryptographic defense, and cannot help
+   keys whose hash values are equal to begin with; for those,
+   long chains are turned into trees (below).
+
+   hash_set_seed() replaces the secret with a given one, for runs
+   that must be replayed exactly. */
+
+/* Secret the seeds derive from, or 0 if not yet drawn. */
+static uint64_t secret;
+
+/* Number of seeds handed out. */
+static uint64_t seed_cnt;
+
+/* Makes the seeds handed out from now on derive from SEED rather
+   than from a random secret, starting over from the first.  The
+   same SEED followed by the same operations then gives the same
+   seeds, and so the same bucket layouts and iteration orders.
+   Tables initialized earlier keep their seeds.  Not to be called
+   while other threads are initializing tables. */
+void
+hash_set_seed (uint64_t seed)
+{
+  __atomic_store_n (&secret, fmix64 (seed) | 1, __ATOMIC_RELAXED);
+  __atomic_store_n (&seed_cnt, 0, __ATOMIC_RELAXED);
+}
+
+/* Returns a seed for a new table: a struct hash, or any other
+   table that scrambles its keys, like intset.c's. */
+uint64_t
+hash_new_seed (void)
+{
+  uint64_t s = __atomic_load_n (&secret, __ATOMIC_RELAXED);
+
+  /* Threads racing here may draw different secrets, which does
+     no harm. */
+  if (s == 0)
+    {
+      if (getentropy (&s, sizeof s) != 0)
+        s = now_ns () ^ (uintptr_t) &s;
+      s |= 1;
+      __atomic_store_n (&secret, s, __ATOMIC_RELAXED);
+    }
+  return fmix64 (s + GOLDEN_64 * __atomic_add_fetch (&seed_cnt, 1,
+                                                      __ATOMIC_RELAXED));
+}
+
+/* Returns the value H uses in place of HASH, which came from its
+   hash function. */
+static inline unsigned
+seed_hash (const struct hash *h, unsigned hash)
+{
+  return fmix64 (hash ^ h->seed);
+}
+
+/* Chain trees.
+
+   Keys whose hash values are equal, or differ only where the
+   seeded value does not pick the bucket, share a chain, and a
+   search walks all of it.  Once a chain is longer than
+   TREEIFY_LEN, a struct hash_tree in `trees' (or `old_trees', for
+   an old bucket) indexes it, and searches go through the tree.
+   The chain stays too, so iteration, migration and the rest of
+   hash.c need not know about trees, only keep them up to date:
+   link_elem() and remove_elem() insert into and delete from the
+   tree, and migrate() drops the tree of a chain it breaks up and
+   extends the others with link_elem().
+   Trees are only an index, so if memory runs out while building
+   or extending one, it is simply dropped.
+
+   Chains are singly linked, and removing an element means
+   updating the pointer to it, so remove_elem() needs the element
+   before it.  A search along the chain passes it anyway.  To
+   find it from the tree in O(log n) as well, a chain with a tree
+   is kept in tree order: treeify() relinks it so, and
+   link_elem() links each new element in right after the one
+   before it in the tree.  tree_link() then finds the pointer to
+   an element with one step back in the tree.
+
+   A search with an element (hash_find() and the like) descends
+   the tree with `less', in O(log n) calls.  A search by key
+   (hash_find_key() and the like) has no `less' for keys, so it
+   descends by hash value to the run of elements sharing the key's
+   hash, then tries `eq' on each of them. */
+
+/* A search key for a tree: an element carrying the hash value
+   sought, plus the element sought, KEY, or a null KEY for "less
+   than every element with this hash value".  A probe's `next'
+   points to the probe itself, which no element in a chain
+   does. */
+struct tree_probe
+  {
+    struct hash_elem elem;      /* Carries the hash value. */
+    const struct hash_elem *key;        /* Element sought, or null. */
+  };
+
+/* Returns the element that A stands for in a tree comparison,
+   which is A itself unless A is a probe. */
+static inline const struct hash_elem *
+probe_key (const struct hash_elem *a)
+{
+  if (a->next != a)
+    return a;
+  return ((const struct tree_probe *) a)->key;
+}
+
+/* Tree order: by cached hash value, then by `less'. */
+static bool
+tree_less (const struct btree_elem *a_, const struct btree_elem *b_,
+           void *tree_)
+{
+  const struct hash_elem *a = btree_to_hash_elem (a_);
+  const struct hash_elem *b = btree_to_hash_elem (b_);
+  const struct hash_tree *tree = tree_;
+
+  if (a->hash != b->hash)
+    return a->hash < b->hash;
+  a = probe_key (a);
+  b = probe_key (b);
+  if (a == NULL || b == NULL)
+    return a == NULL && b != NULL;
+  return tree->less (a, b, tree->aux);
+}
+
+/* Returns the slot in H's tree arrays for BUCKET, or a null
+   pointer if the array it would be in does not exist. */
+static struct hash_tree **
+tree_slot (struct hash *h, struct hash_elem **bucket)
+{
+  if (is_old_bucket (h, bucket))
+    return (h->old_trees != NULL
+            ? &h->old_trees[bucket - h->old_buckets] : NULL);
+  return h->trees != NULL ? &h->trees[bucket - h->buckets] : NULL;
+}
+
+/* Returns true if the chain starting at E holds more than LEN
+   elements, looking at no more than LEN + 1 of them. */
+static bool
+chain_longer_than (struct hash_elem *e, size_t len)
+{
+  for (; e != NULL; e = e->next)
+    if (len-- == 0)
+      return true;
+  return false;
+}
+
+/* Searches TREE for the element KEY, whose hash value is HASH,
+   as find_elem() would search its chain, and adds the number of
+   elements compared by `eq' or found to *PROBE_CNT.  AUX is H's
+   auxiliary data. */
+static struct hash_elem *
+tree_find (struct hash_tree *tree, const void *key, hash_key_eq_func *key_eq,
+           unsigned hash, void *aux, size_t *probe_cnt)
+{
+  struct btree_iterator i;
+  struct tree_probe probe;
+  struct btree_elem *e;
+
+  probe.elem.next = &probe.elem;
+  probe.elem.hash = hash;
+  if (key_eq == NULL)
+    {
+      probe.key = key;
+      e = btree_find (&tree->tree, hash_to_btree_elem (&probe.elem));
+      *probe_cnt += e != NULL;
+      return btree_to_hash_elem (e);
+    }
+
+  probe.key = NULL;
+  for (e = btree_lower_bound (&i, &tree->tree,
+                              hash_to_btree_elem (&probe.elem));
+       e != NULL && btree_to_hash_elem (e)->hash == hash;
+       e = btree_next (&i))
+    {
+      ++*probe_cnt;
+      if (key_eq (btree_to_hash_elem (e), key, aux))
+        return btree_to_hash_elem (e);
+    }
+  return NULL;
+}
+
+/* Returns the pointer to E in the chain of BUCKET, which TREE
+   indexes: BUCKET itself if E is first in tree order, and
+   otherwise the `next' of the element before E. */
+static struct hash_elem **
+tree_link (struct hash_tree *tree, struct hash_elem **bucket,
+           struct hash_elem *e)
+{
+  struct btree_iterator i;
+  struct btree_elem *prev;
+
+  btree_lower_bound (&i, &tree->tree, hash_to_btree_elem (e));
+  prev = btree_prev (&i);
+  return prev != NULL ? &btree_to_hash_elem (prev)->next : bucket;
+}
+
+/* Indexes BUCKET, a chain in H, with a tree, and relinks the
+   chain in tree order.  Does nothing if memory is exhausted. */
+static void
+treeify (struct hash *h, struct hash_elem **bucket)
+{
+  struct hash_tree **slot;
+  struct hash_tree *tree;
+  struct hash_elem *e, **link;
+  struct btree_iterator i;
+  struct btree_elem *t;
+
+  /* The arrays of trees are allocated on first use, so a table
+     that never sees a long chain does not pay for them. */
+  if (tree_slot (h, bucket) == NULL)
+    {
+      bool old = is_old_bucket (h, bucket);
+      size_t cnt = old ? h->old_bucket_cnt : h->bucket_cnt;
+      struct hash_tree **trees = calloc (cnt, sizeof *trees);
+
+      if (trees == NULL)
+        return;
+      if (old)
+        h->old_trees = trees;
+      else
+        h->trees = trees;
+    }
+  slot = tree_slot (h, bucket);
+
+  tree = malloc (sizeof *tree);
+  if (tree == NULL)
+    return;
+  btree_init (&tree->tree, tree_less, tree);
+  tree->less = h->less;
+  tree->aux = h->aux;
+  *slot = tree;
+  h->tree_cnt++;
+
+  for (e = *bucket; e != NULL; e = e->next)
+    if (btree_insert (&tree->tree, hash_to_btree_elem (e)) != NULL)
+      {
+        drop_tree (h, slot);
+        return;
+      }
+
+  link = bucket;
+  for (t = btree_first (&i, &tree->tree); t != NULL; t = btree_next (&i))
+    {
+      *link = btree_to_hash_elem (t);
+      link = &(*link)->next;
+    }
+  *link = NULL;
+}
+
+/* Frees the tree in *SLOT, one of H's, and empties the slot. */
+static void
+drop_tree (struct hash *h, struct hash_tree **slot)
+{
+  btree_destroy (&(*slot)->tree, NULL);
+  free (*slot);
+  *slot = NULL;
+  h->tree_cnt--;
+}
+
+/* Frees every tree in *TREES, an array of CNT slots of H's, if
+   it exists, and then the array itself. */
+static void
+drop_trees (struct hash *h, struct hash_tree ***trees, size_t cnt)
+{
+  size_t i;
+
+  if (*trees == NULL)
+    return;
+  for (i = 0; i < cnt; i++)
+    if ((*trees)[i] != NULL)
+      drop_tree (h, &(*trees)[i]);
+  free (*trees);
+  *trees = NULL;
+}
+
+/* Bloom filter.
+
+   The filter of a table with BUCKET_CNT buckets has
+   BLOOM_BITS_PER_BUCKET bits for each bucket, which is 8 bits per
+   element when the table is as full as it gets before growing
+   (MAX_ELEMS_PER_BUCKET) and 16 at its usual load.  With
+   BLOOM_HASH_CNT bits set per element, that lets through about
+   2.5% and 0.1% of misses, respectively.
+
+   The bits for an element come from its cached 32-bit hash,
+   stirred into 64 bits by fmix64().  The low half picks a block
+   of BLOOM_BLOCK_BITS bits, about a cache line, and all the bits
+   for the element fall inside it: the high half gives the first
+   one, and, made odd, the stride to the others ("double
+   hashing", after Kirsch and Mitzenmacher).  A test thus costs
+   one cache miss rather than one per bit, for a slightly higher
+   false positive rate than bits spread over the whole filter.
+   Because the block size is a power of 2 and the stride is odd,
+   the bits of one element are all distinct. */
+
+#define BLOOM_BITS_PER_BUCKET 32
+#define BLOOM_BLOCK_BITS 512
+#define BLOOM_HASH_CNT 6
+
+/* Returns the number of bits in the Bloom filter of a table of
+   BUCKET_CNT buckets, a power of 2, at least one block. */
+static size_t
+bloom_bit_cnt (size_t bucket_cnt)
+{
+  size_t bit_cnt = bucket_cnt * BLOOM_BITS_PER_BUCKET;
+
+  return bit_cnt > BLOOM_BLOCK_BITS ? bit_cnt : BLOOM_BLOCK_BITS;
+}
+
+/* Computes where the bits for hash HASH lie in Bloom filter B:
+   bit I is at *BLOCK plus (*IDX + I * *STEP) modulo
+   BLOOM_BLOCK_BITS. */
+static inline void
+bloom_bits (const struct bitmap *b, unsigned hash,
+            size_t *block, size_t *idx, size_t *step)
+{
+  uint64_t x = fmix64 (hash);
+  uint32_t hi = x >> 32;
+
+  *block = (size_t) x & (bitmap_size (b) - 1) & ~(size_t) (BLOOM_BLOCK_BITS - 1);
+  *idx = hi;
+  *step = (hi >> 16) | 1;
+}
+
+/* Sets the bits for an element whose hash is HASH in Bloom
+   filter B. */
+static void
+bloom_add (struct bitmap *b, unsigned hash)
+{
+  size_t block, idx, step;
+  int i;
+
+  bloom_bits (b, hash, &block, &idx, &step);
+  for (i = 0; i < BLOOM_HASH_CNT; i++, idx += step)
+    bitmap_mark (b, block + (idx & (BLOOM_BLOCK_BITS - 1)));
+}
+
+/* Returns false if Bloom filter B shows that no element whose
+   hash is HASH was added to it, true if one may have been. */
+static bool
+bloom_test (const struct bitmap *b, unsigned hash)
+{
+  size_t block, idx, step;
+  int i;
+
+  bloom_bits (b, hash, &block, &idx, &step);
+  for (i = 0; i < BLOOM_HASH_CNT; i++, idx += step)
+    if (!bitmap_test (b, block + (idx & (BLOOM_BLOCK_BITS - 1))))
+      return false;
+  return true;
+}
+
+/* Adds 1 to H's Bloom filter counter *CNT, in the manner of
+   count_lookup(). */
+static inline void
+count_bloom (struct hash *h, size_t *cnt)
+{
+  if (!h->count_searches)
+    return;
+  __atomic_store_n (cnt, __atomic_load_n (cnt, __ATOMIC_RELAXED) + 1,
+                    __ATOMIC_RELAXED);
+}
+
+/* Open addressing.
+
+   A table set up by hash_init_open() keeps its elements in an
+   array of BUCKET_CNT slots, each holding a pointer to an element
+   or nothing, next to an array of control bytes, one per slot:
+
+     CTRL_EMPTY      the slot has been empty since the last resize.
+     CTRL_DELETED    the slot's element was deleted (a tombstone).
+     0...127         the slot is in use; the byte holds the low 7
+                     bits of the element's hash, its "H2".
+
+   The whole hash, through bucket_index(), picks the slot where
+   probing starts.  Probing reads GROUP_WIDTH control bytes at a
+   time: one comparison yields every slot of the group whose H2
+   matches, and only those elements are compared with the one
+   looked for, so a lookup usually touches one element.  A group
+   with an empty slot in it ends the probe.  The first GROUP_WIDTH
+   control bytes are repeated after the last one, so that a group
+   can always be loaded in one piece, even where it wraps around.
+
+   At most 7/8 of the slots may be in use or deleted.  Once that
+   is reached the table is rebuilt, at a size chosen so that it
+   is at most 7/16 full afterward; deletions shrink it the same
+   way once it falls below 1/16 full. */
+
+#define GROUP_WIDTH 16                  /* Control bytes per probe. */
+#define CTRL_EMPTY ((int8_t) -128)      /* Never-used slot. */
+#define CTRL_DELETED ((int8_t) -2)      /* Tombstone. */
+#define MIN_SLOT_CNT 16                 /* At least one whole group. */
+
+/* One bit per control byte of a group, lowest bit first. */
+typedef unsigned group_mask;
+
+/* Returns the part of HASH kept in a slot's control byte. */
+static inline int8_t
+hash_h2 (unsigned hash)
+{
+  return hash & 0x7f;
+}
+
+/* Returns the bytes of the group at CTRL that equal BYTE. */
+static inline group_mask
+group_match (const int8_t *ctrl, int8_t byte)
+{
+#ifdef __SSE2__
+  __m128i group = _mm_loadu_si128 ((const __m128i *) ctrl);
+  return _mm_movemask_epi8 (_mm_cmpeq_epi8 (group, _mm_set1_epi8 (byte)));
+#else
+  group_mask mask = 0;
+  int i;
+
+  for (i = 0; i < GROUP_WIDTH; i++)
+    if (ctrl[i] == byte)
+      mask |= (group_mask) 1 << i;
+  return mask;
+#endif
+}
+
+/* Returns the bytes of the group at CTRL that are empty or
+   deleted, which are exactly the negative ones. */
+static inline group_mask
+group_match_free (const int8_t *ctrl)
+{
+#ifdef __SSE2__
+  return _mm_movemask_epi8 (_mm_loadu_si128 ((const __m128i *) ctrl));
+#else
+  group_mask mask = 0;
+  int i;
+
+  for (i = 0; i < GROUP_WIDTH; i++)
+    if (ctrl[i] < 0)
+      mask |= (group_mask) 1 << i;
+  return mask;
+#endif
+}
+
+/* Returns the number of slots that may be in use or deleted in
+   a table of SLOT_CNT slots before it must be rebuilt. */
+static inline size_t
+max_load (size_t slot_cnt)
+{
+  return slot_cnt - slot_cnt / 8;
+}
+
+/* Returns the number of slots H should be rebuilt with to hold
+   ELEM_CNT elements: the smallest power of 2, no less than H's
+   minimum size, that is at most 7/16 full. */
+static size_t
+open_slot_cnt (const struct hash *h, size_t elem_cnt)
+{
+  size_t slot_cnt = h->min_bucket_cnt;
+
+  while (slot_cnt * 7 / 16 < elem_cnt)
+    slot_cnt *= 2;
+  return slot_cnt;
+}
+
+/* Sets the control byte of slot I in H to CTRL, and its copy if
+   it has one. */
+static inline void
+set_ctrl (struct hash *h, size_t i, int8_t ctrl)
+{
+  h->ctrl[i] = ctrl;
+  if (i < GROUP_WIDTH)
+    h->ctrl[h->bucket_cnt + i] = ctrl;
+}
+
+/* Gives H an empty array of SLOT_CNT slots, a power of 2 no less
+   than MIN_SLOT_CNT, without freeing the old one.  Returns false
+   if memory is exhausted, leaving H unchanged. */
+static bool
+open_alloc (struct hash *h, size_t slot_cnt)
+{
+  int8_t *ctrl = malloc (slot_cnt + GROUP_WIDTH);
+  struct hash_elem **slots = malloc (sizeof *slots * slot_cnt);
+
+  if (ctrl == NULL || slots == NULL)
+    {
+      free (ctrl);
+      free (slots);
+      return false;
+    }
+
+  memset (ctrl, CTRL_EMPTY, slot_cnt + GROUP_WIDTH);
+  h->ctrl = ctrl;
+  h->slots = slots;
+  h->bucket_cnt = slot_cnt;
+  h->growth_left = max_load (slot_cnt);
+  return true;
+}
+
+/* Sets up H, whose other members are already initialized, as an
+   empty open addressing table with room for ELEM_CNT elements. */
+static bool
+open_init (struct hash *h, size_t elem_cnt)
+{
+  h->ctrl = NULL;
+  h->slots = NULL;
+  h->bucket_cnt = 0;
+  h->growth_left = 0;
+  h->min_bucket_cnt = MIN_SLOT_CNT;
+  return open_alloc (h, open_slot_cnt (h, elem_cnt));
+}
+
+/* Puts E, whose hash is HASH and which must not be in H yet, in
+   the first free slot of its probe sequence. */
+static void
+open_place (struct hash *h, unsigned hash, struct hash_elem *e)
+{
+  size_t mask = h->bucket_cnt - 1;
+  size_t pos = bucket_index (hash, h->bucket_cnt);
+  size_t step = 0;
+  group_mask free_mask;
+
+  while ((free_mask = group_match_free (h->ctrl + pos)) == 0)
+    {
+      step += GROUP_WIDTH;
+      pos = (pos + step) & mask;
+    }
+
+  pos = (pos + __builtin_ctz (free_mask)) & mask;
+  if (h->ctrl[pos] == CTRL_EMPTY && h->growth_left > 0)
+    h->growth_left--;
+  set_ctrl (h, pos, hash_h2 (hash));
+  e->hash = hash;
+  h->slots[pos] = e;
+  h->elem_cnt++;
+}
+
+/* Rebuilds H with SLOT_CNT slots, dropping all tombstones.
+   Returns false if memory is exhausted, leaving H as it was,
+   which is still usable. */
+static bool
+open_resize (struct hash *h, size_t slot_cnt)
+{
+  int8_t *old_ctrl = h->ctrl;
+  struct hash_elem **old_slots = h->slots;
+  size_t old_slot_cnt = h->bucket_cnt;
+  uint64_t start = now_ns ();
+  size_t i;
+
+  if (!open_alloc (h, slot_cnt))
+    return false;
+  h->rehash_cnt++;
+
+  h->elem_cnt = 0;
+  for (i = 0; i < old_slot_cnt; i++)
+    if (old_ctrl[i] >= 0)
+      open_place (h, old_slots[i]->hash, old_slots[i]);
+
+  free (old_ctrl);
+  free (old_slots);
+  h->rehash_ns += now_ns () - start;
+  return true;
+}
+
+/* Makes sure H has room to place one more element, growing it
+   if necessary.  Returns false if memory is exhausted.  H must
+   not take another element then: past its maximum load, placing
+   elements anyway would eventually leave no free slot, and
+   open_place()'s probe would never end. */
+static bool
+open_make_room (struct hash *h)
+{
+  return (h->growth_left > 0
+          || open_resize (h, open_slot_cnt (h, h->elem_cnt + 1)));
+}
+
+/* Searches H, along the probe sequence of HASH, for the element
+   KEY (see elem_matches()).  Returns it and stores its slot in
+   *SLOT, if SLOT is non-null, or returns a null pointer if there
+   is none. */
+static struct hash_elem *
+open_lookup (struct hash *h, unsigned hash, const void *key,
+             hash_key_eq_func *key_eq, size_t *slot)
+{
+  size_t mask = h->bucket_cnt - 1;
+  size_t pos = bucket_index (hash, h->bucket_cnt);
+  size_t step = 0;
+  size_t probe_cnt = 0;
+
+  for (;;)
+    {
+      const int8_t *group = h->ctrl + pos;
+      group_mask match;
+
+      probe_cnt++;
+      for (match = group_match (group, hash_h2 (hash)); match != 0;
+           match &= match - 1)
+        {
+          size_t i = (pos + __builtin_ctz (match)) & mask;
+          struct hash_elem *hi = h->slots[i];
+
+          if (hi->hash == hash && elem_matches (h, hi, key, key_eq))
+            {
+              if (slot != NULL)
+                *slot = i;
+              count_lookup (h, probe_cnt);
+              return hi;
+            }
+        }
+      if (group_match (group, CTRL_EMPTY) != 0)
+        {
+          count_lookup (h, probe_cnt);
+          return NULL;
+        }
+
+      step += GROUP_WIDTH;
+      pos = (pos + step) & mask;
+    }
+}
+
+/* Open addressing hash_find().  Stores the slot of the element
+   found in *SLOT, if SLOT is non-null. */
+static struct hash_elem *
+open_find (struct hash *h, struct hash_elem *e, size_t *slot)
+{
+  return open_lookup (h, seed_hash (h, h->hash (e, h->aux)), e, NULL, slot);
+}
+
+/* Open addressing hash_insert(), or hash_replace() if REPLACE is
+   true. */
+static struct hash_elem *
+open_insert (struct hash *h, struct hash_elem *new, bool replace)
+{
+  unsigned hash = seed_hash (h, h->hash (new, h->aux));
+  size_t slot;
+  struct hash_elem *old = open_lookup (h, hash, new, NULL, &slot);
+
+  if (old != NULL)
+    {
+      /* Equal elements hash alike, so the control byte stays. */
+      if (replace)
+        {
+          new->hash = hash;
+          h->slots[slot] = new;
+        }
+      return old;
+    }
+
+  if (!open_make_room (h))
+    return new;
+  open_place (h, hash, new);
+  return NULL;
+}
+
+/* Open addressing hash_delete(). */
+static struct hash_elem *
+open_delete (struct hash *h, struct hash_elem *e)
+{
+  size_t slot;
+  struct hash_elem *found = open_find (h, e, &slot);
+
+  if (found != NULL)
+    open_remove (h, slot);
+  return found;
+}
+
+/* Removes the element in SLOT of H, shrinking H if it has become
+   mostly empty. */
+static void
+open_remove (struct hash *h, size_t slot)
+{
+  set_ctrl (h, slot, CTRL_DELETED);
+  h->elem_cnt--;
+  if (h->bucket_cnt > h->min_bucket_cnt
+      && h->elem_cnt < h->bucket_cnt / 16)
+    open_resize (h, open_slot_cnt (h, h->elem_cnt));
+}
+
+/* Open addressing hash_upsert(). */
+static struct hash_elem *
+open_upsert (struct hash *h, const void *key, unsigned hash,
+             hash_key_eq_func *key_eq, hash_make_func *make,
+             hash_action_func *update)
+{
+  struct hash_elem *e = open_lookup (h, hash, key, key_eq, NULL);
+
+  if (e != NULL)
+    {
+      if (update != NULL)
+        update (e, h->aux);
+      return e;
+    }
+
+  if (!open_make_room (h))
+    return NULL;
+  e = make (key, h->aux);
+  if (e == NULL)
+    return NULL;
+  open_place (h, hash, e);
+  return e;
+}
+
+/* Open addressing hash_reserve(). */
+static bool
+open_reserve (struct hash *h, size_t elem_cnt)
+{
+  size_t slot_cnt = MIN_SLOT_CNT;
+
+  while (max_load (slot_cnt) < elem_cnt)
+    slot_cnt *= 2;
+
+  /* Tombstones use up growth too, so a big enough table may
+     still need rebuilding. */
+  if (slot_cnt > h->bucket_cnt || h->elem_cnt + h->growth_left < elem_cnt)
+    {
+      if (slot_cnt < h->bucket_cnt)
+        slot_cnt = h->bucket_cnt;
+      if (!open_resize (h, slot_cnt))
+        return false;
+    }
+  if (slot_cnt > h->min_bucket_cnt)
+    h->min_bucket_cnt = slot_cnt;
+  return true;
+}
+
+/* Open addressing hash_shrink_to_fit(). */
+static void
+open_shrink_to_fit (struct hash *h)
+{
+  size_t slot_cnt;
+
+  h->min_bucket_cnt = MIN_SLOT_CNT;
+  slot_cnt = open_slot_cnt (h, h->elem_cnt);
+  if (slot_cnt < h->bucket_cnt)
+    open_resize (h, slot_cnt);
+}
+
+/* Open addressing hash_clear(). */
+static void
+open_clear (struct hash *h, hash_action_func *destructor)
+{
+  size_t i;
+
+  if (destructor != NULL)
+    for (i = open_next_full (h, 0); i < h->bucket_cnt;
+         i = open_next_full (h, i + 1))
+      destructor (h->slots[i], h->aux);
+
+  memset (h->ctrl, CTRL_EMPTY, h->bucket_cnt + GROUP_WIDTH);
+  h->elem_cnt = 0;
+  h->growth_left = max_load (h->bucket_cnt);
+}
+
+/* Returns the number of groups a lookup examines to reach the
+   element in SLOT of H. */
+static size_t
+open_chain_len (struct hash *h, size_t slot)
+{
+  size_t mask = h->bucket_cnt - 1;
+  size_t pos = bucket_index (h->slots[slot]->hash, h->bucket_cnt);
+  size_t step = 0;
+  size_t len = 1;
+
+  while (((slot - pos) & mask) >= GROUP_WIDTH)
+    {
+      step += GROUP_WIDTH;
+      pos = (pos + step) & mask;
+      len++;
+    }
+  return len;
+}
+
+/* Returns the first slot in H at or after SLOT that holds an
+   element, or BUCKET_CNT if there is none. */
+static size_t
+open_next_full (struct hash *h, size_t slot)
+{
+  while (slot < h->bucket_cnt)
+    {
+      group_mask full = ~group_match_free (h->ctrl + slot)
+                        & ((1u << GROUP_WIDTH) - 1);
+
+      if (full != 0)
+        {
+          /* A hit past the end is a copy of a byte at the start. */
+          slot += __builtin_ctz (full);
+          return slot < h->bucket_cnt ? slot : h->bucket_cnt;
+        }
+      slot += GROUP_WIDTH;
+    }
+  return h->bucket_cnt;
+}
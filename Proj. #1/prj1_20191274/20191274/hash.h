@@ -6,21 +6,65 @@
   This is a standard hash table with chaining.  To locate an
    element in the table, we compute a hash function over the
    element's data and use that as an index into an array of
-   doubly linked lists, then linearly search the list.
+   chains, then linearly search the chain.
 
-   The chain lists do not use dynamic allocation.  Instead, each
+   Each bucket is a single pointer to the first element of its
+   chain, and each element points to the next, so an empty
+   bucket costs 8 bytes, not the 32 of a doubly linked list's
+   head and tail, and an element carries one link, not two.
+   Removal still takes no extra pass over the chain: the search
+   that finds the element passes the link pointing to it.
+
+   The chains do not use dynamic allocation.  Instead, each
    structure that can potentially be in a hash must embed a
    struct hash_elem member.  All of the hash functions operate on
    these `struct hash_elem's.  The hash_entry macro allows
    conversion from a struct hash_elem back to a structure object
    that contains it.  This is the same technique used in the
    linked list implementation.  Refer to ./list.h for a
-   detailed explanation. */
+   detailed explanation.
+
+   Growing or shrinking the bucket array is done incrementally:
+   the old array is kept next to the new one, and each insertion,
+   replacement, or deletion moves a few old buckets over, so no
+   single operation pays for moving the whole table.
+
+   A bitmap of the non-empty buckets lets iteration jump from one
+   element to the next, so walking a sparse table, say after a
+   mass deletion or a hash_reserve(), costs time proportional to
+   its elements rather than its buckets.
+
+   A table initialized with hash_init_open() instead uses open
+   addressing, in the style of a "Swiss table": the elements are
+   kept in a flat array of pointers, next to an array of one-byte
+   control words holding 7 bits of each element's hash, and a
+   lookup compares a whole group of 16 control bytes at once
+   (with SSE2 where available) before looking at any element.
+   Such a table supports exactly the same functions; only the
+   struct hash_elem's `next' member goes unused.
+
+   A chained table can also carry a Bloom filter of its elements'
+   hashes (see hash_set_bloom()).  A search for an element that
+   is not there then usually ends after testing a bit or two of
+   the filter, without walking a chain or calling `less'.
+
+   Every table scrambles the hash values it is given with a seed
+   of its own, drawn at random when it is initialized, so keys
+   crafted to land in one bucket of one table, or of every table
+   in one run, land all over the buckets of another.  That does
+   nothing for keys whose hash values are themselves equal, so a
+   chain that grows long anyway is also indexed by a B+-tree
+   ordered by `less' (see btree.h), which bounds the cost of
+   searching it to O(log n); the tree goes away once the chain
+   is short again.  For a run that must be replayed exactly,
+   hash_set_seed() makes the seeds repeatable. */
 
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
-#include "list.h"
+
+struct bitmap;
+struct hash_tree;
 
 /* Hash element. */
 /* 
@@ -28,8 +72,9 @@
 */
 struct hash_elem 
   {
-    struct list_elem list_elem;
+    struct hash_elem *next;     /* Next element in the chain. */
     int              value;
+    unsigned         hash;      /* Cached hash value, set on insertion. */
   };
 
 /* Computes and returns the hash value for hash element E, given
@@ -43,42 +88,159 @@ typedef bool hash_less_func (const struct hash_elem *a,
                              const struct hash_elem *b,
                              void *aux);
 
+/* Returns true if hash elements A and B are equal, given
+   auxiliary data AUX.  Optional; see hash_set_eq(). */
+typedef bool hash_eq_func (const struct hash_elem *a,
+                           const struct hash_elem *b,
+                           void *aux);
+
+/* Returns true if hash element E has key KEY, given auxiliary
+   data AUX.  Used by the key-based functions, such as
+   hash_find_key(), in place of an element to compare with. */
+typedef bool hash_key_eq_func (const struct hash_elem *e, const void *key,
+                               void *aux);
+
+/* Returns a new hash element with key KEY, for hash_upsert() to
+   insert, given auxiliary data AUX.  Returns a null pointer if
+   memory is exhausted. */
+typedef struct hash_elem *hash_make_func (const void *key, void *aux);
+
 /* Performs some operation on hash element E, given auxiliary
    data AUX. */
 typedef void hash_action_func (struct hash_elem *e, void *aux);
 
+/* Folds hash element E into the partial result ACC, given
+   auxiliary data AUX. */
+typedef void hash_fold_func (struct hash_elem *e, void *acc, void *aux);
+
+/* Merges the partial result SRC into DST, given auxiliary data
+   AUX. */
+typedef void hash_merge_func (void *dst, const void *src, void *aux);
+
 /* Hash table. */
 struct hash 
   {
     size_t elem_cnt;            /* Number of elements in table. */
-    size_t bucket_cnt;          /* Number of buckets, a power of 2. */
-    struct list *buckets;       /* Array of `bucket_cnt' lists. */
+    size_t bucket_cnt;          /* Number of buckets (or slots), a power of 2. */
+    size_t min_bucket_cnt;      /* Never shrink below this many. */
+    struct hash_elem **buckets; /* Array of `bucket_cnt' chain heads. */
+    struct hash_elem **old_buckets; /* Buckets being rehashed, or null. */
+    size_t old_bucket_cnt;      /* Number of buckets in `old_buckets'. */
+    size_t migrate_idx;         /* Old buckets below this are empty. */
+    struct bitmap *occupied;    /* Non-empty buckets in `buckets'. */
+    struct bitmap *old_occupied; /* Non-empty buckets in `old_buckets'. */
+    struct bitmap *bloom;       /* Bloom filter of element hashes, or null. */
+    struct bitmap *next_bloom;  /* Filter for `buckets' during a rehash. */
+    struct hash_tree **trees;   /* Trees of long chains in `buckets', or null. */
+    struct hash_tree **old_trees; /* Same, for `old_buckets'. */
+    size_t tree_cnt;            /* Non-null entries in those arrays. */
+    uint64_t seed;              /* Scrambles hash values; see hash.h. */
     hash_hash_func *hash;       /* Hash function. */
     hash_less_func *less;       /* Comparison function. */
+    hash_eq_func *eq;           /* Equality function, or null. */
     void *aux;                  /* Auxiliary data for `hash' and `less'. */
+
+    /* Open addressing only (hash_init_open()); otherwise null. */
+    int8_t *ctrl;               /* `bucket_cnt' + 16 control bytes. */
+    struct hash_elem **slots;   /* Array of `bucket_cnt' elements. */
+    size_t growth_left;         /* Empty slots usable before growing. */
+
+    /* Statistics; see hash_stats(). */
+    size_t rehash_cnt;          /* Resizes started. */
+    uint64_t rehash_ns;         /* Nanoseconds spent resizing. */
+    bool count_searches;        /* Keep the search counters below? */
+    size_t lookup_cnt;          /* Searches for an element. */
+    size_t probe_cnt;           /* Chain nodes or groups they examined. */
+    size_t bloom_neg_cnt;       /* Searches the Bloom filter ended. */
+    size_t bloom_fp_cnt;        /* Searches it passed that found nothing. */
+  };
+
+/* Length of the chain-length histogram in struct hash_stats. */
+#define HASH_STATS_HIST 8
+
+/* A snapshot of a hash table's shape and counters, filled in by
+   hash_stats().  `rehash_ns' adds up the time spent allocating
+   new arrays and moving elements into them, not the time a table
+   sits between operations while a resize is in progress.  The
+   search counters, from `lookup_cnt' on, count every search for
+   an element (by finds, insertions, deletions and upserts alike),
+   and only once hash_set_stats() turns them on; otherwise they
+   stay 0.  For a table using open addressing, "chains" are probe
+   sequences: an element's chain length is the number of 16-slot
+   groups a lookup examines before finding it, and the histogram
+   counts elements rather than buckets. */
+struct hash_stats
+  {
+    size_t elem_cnt;            /* Number of elements. */
+    size_t bucket_cnt;          /* Number of buckets (or slots). */
+    double load_factor;         /* Elements per bucket (or slot). */
+    size_t rehash_cnt;          /* Resizes since hash_init(). */
+    uint64_t rehash_ns;         /* Nanoseconds spent resizing. */
+    size_t lookup_cnt;          /* Searches counted. */
+    size_t probe_cnt;           /* Chain nodes or groups they examined. */
+    size_t bloom_bit_cnt;       /* Size of the Bloom filter, or 0. */
+    size_t bloom_neg_cnt;       /* Searches it ended as definite misses. */
+    size_t bloom_fp_cnt;        /* Searches it passed that found nothing. */
+    size_t tree_cnt;            /* Chains indexed by a tree. */
+    size_t max_chain;           /* Longest chain. */
+    double mean_chain;          /* Mean length of non-empty chains. */
+    size_t chain_hist[HASH_STATS_HIST];
+                                /* Chains of each length; the last
+                                   entry counts all longer ones too. */
   };
 
 /* A hash table iterator. */
 struct hash_iterator 
   {
     struct hash *hash;          /* The hash table. */
-    struct list *bucket;        /* Current bucket. */
+    struct hash_elem **bucket;  /* Current bucket. */
     struct hash_elem *elem;     /* Current hash element in current bucket. */
+    size_t slot;                /* Current slot, for open addressing. */
   };
 
 /* Basic life cycle. */
 bool hash_init (struct hash *, hash_hash_func *, hash_less_func *, void *aux);
+bool hash_init_open (struct hash *, hash_hash_func *, hash_less_func *,
+                     void *aux);
 void hash_clear (struct hash *, hash_action_func *);
 void hash_destroy (struct hash *, hash_action_func *);
+void hash_set_eq (struct hash *, hash_eq_func *);
+bool hash_set_bloom (struct hash *, bool);
+void hash_set_stats (struct hash *, bool);
+
+/* Sizing. */
+bool hash_reserve (struct hash *, size_t elem_cnt);
+void hash_shrink_to_fit (struct hash *);
+
+/* Snapshots. */
+bool hash_save (struct hash *, const char *file_name);
+bool hash_load (struct hash *, const char *file_name, hash_make_func *);
 
 /* Search, insertion, deletion. */
 struct hash_elem *hash_insert (struct hash *, struct hash_elem *);
 struct hash_elem *hash_replace (struct hash *, struct hash_elem *);
 struct hash_elem *hash_find (struct hash *, struct hash_elem *);
+void hash_find_batch (struct hash *, struct hash_elem *keys[], size_t n,
+                      struct hash_elem *out[]);
 struct hash_elem *hash_delete (struct hash *, struct hash_elem *);
+void hash_remove (struct hash *, struct hash_elem *);
+
+/* Search, insertion, deletion by key. */
+struct hash_elem *hash_find_key (struct hash *, const void *key,
+                                 unsigned hash, hash_key_eq_func *);
+struct hash_elem *hash_delete_key (struct hash *, const void *key,
+                                   unsigned hash, hash_key_eq_func *);
+struct hash_elem *hash_upsert (struct hash *, const void *key, unsigned hash,
+                               hash_key_eq_func *, hash_make_func *,
+                               hash_action_func *);
 
 /* Iteration. */
 void hash_apply (struct hash *, hash_action_func *);
+void hash_apply_parallel (struct hash *, size_t thread_cnt,
+                          hash_action_func *);
+void hash_reduce_parallel (struct hash *, size_t thread_cnt,
+                           hash_fold_func *, hash_merge_func *,
+                           void *acc, size_t acc_size);
 void hash_first (struct hash_iterator *, struct hash *);
 struct hash_elem *hash_next (struct hash_iterator *);
 struct hash_elem *hash_cur (struct hash_iterator *);
@@ -86,11 +248,17 @@ struct hash_elem *hash_cur (struct hash_iterator *);
 /* Information. */
 size_t hash_size (struct hash *);
 bool hash_empty (struct hash *);
+void hash_stats (struct hash *, struct hash_stats *);
+
+/* Seeding. */
+void hash_set_seed (uint64_t seed);
+uint64_t hash_new_seed (void);
 
 /* Sample hash functions. */
 unsigned hash_bytes (const void *, size_t);
 unsigned hash_string (const char *);
 unsigned hash_int (int);
+unsigned hash_u64 (uint64_t);
 
 // --- SP Prj. #1. ---.
 unsigned hash_int_2 (int);
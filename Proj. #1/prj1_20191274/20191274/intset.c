@@ -0,0 +1,614 @@
+/* Flat integer set and map.
+
+See intset.h for basic information. */
+
+#include "intset.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "hash.h"
+#include "snapshot.h"
+
+#define ASSERT(CONDITION) assert(CONDITION)
+
+#define MIN_SLOT_CNT 16         /* Never fewer slots than this. */
+
+/* 2**64 divided by the golden ratio, as in hash.c. */
+#define GOLDEN_64 0x9e3779b97f4a7c15ull
+
+/* Slot numbers that are not indexes into `keys'. */
+#define EMPTY_KEY_SLOT ((size_t) -2)    /* Where INT_SET_EMPTY lives. */
+#define NO_SLOT ((size_t) -1)           /* Out of memory. */
+
+/* Returns the most keys that SLOT_CNT slots may hold before the
+   table grows: 7/8 of them.  Linear probing over inline keys
+   stays fast at that load, since a probe sequence is a scan
+   through consecutive ints. */
+static inline size_t
+max_load (size_t slot_cnt)
+{
+  return slot_cnt - slot_cnt / 8;
+}
+
+/* Returns the slot of S where KEY's probe sequence starts.  This
+   is Fibonacci hashing, as in hash.c's bucket_index(): the top
+   bits of the product depend on every bit of KEY, so runs of
+   consecutive keys do not pile up in consecutive slots.  XORing
+   in S's seed first changes which keys share a home slot from
+   set to set. */
+static inline size_t
+home_slot (const struct int_set *s, int key)
+{
+  return (size_t) (((uint64_t) ((uint32_t) key ^ s->seed) * GOLDEN_64)
+                   >> (64 - __builtin_ctzll (s->slot_cnt)));
+}
+
+/* Searches S for KEY, which must not be INT_SET_EMPTY.  Returns
+   true and stores its slot in *SLOT if it is there, otherwise
+   returns false and stores in *SLOT the empty slot where it
+   would go. */
+static inline bool
+find_slot (const struct int_set *s, int key, size_t *slot)
+{
+  size_t mask = s->slot_cnt - 1;
+  size_t i;
+
+  for (i = home_slot (s, key); ; i = (i + 1) & mask)
+    {
+      int k = s->keys[i];
+
+      if (k == key || k == INT_SET_EMPTY)
+        {
+          *slot = i;
+          return k == key;
+        }
+    }
+}
+
+/* Returns the number of slots best suited to KEY_CNT keys in S:
+   the smallest power of 2, no less than S's minimum, that holds
+   them without growing. */
+static size_t
+slot_cnt_for (const struct int_set *s, size_t key_cnt)
+{
+  size_t slot_cnt = s->min_slot_cnt;
+
+  while (max_load (slot_cnt) < key_cnt)
+    slot_cnt *= 2;
+  return slot_cnt;
+}
+
+/* Allocates arrays of SLOT_CNT empty slots for S, plus values
+   if WITH_VALUES, and stores them in *KEYS and *VALUES.  Returns
+   false if memory is exhausted. */
+static bool
+alloc_slots (size_t slot_cnt, bool with_values, int **keys, int **values)
+{
+  size_t i;
+
+  *keys = malloc (sizeof **keys * slot_cnt);
+  *values = with_values ? malloc (sizeof **values * slot_cnt) : NULL;
+  if (*keys == NULL || (with_values && *values == NULL))
+    {
+      free (*keys);
+      free (*values);
+      return false;
+    }
+
+  for (i = 0; i < slot_cnt; i++)
+    (*keys)[i] = INT_SET_EMPTY;
+  return true;
+}
+
+/* Moves the keys of S, and their values, into SLOT_CNT new
+   slots.  Returns false, leaving S as it was, if memory is
+   exhausted. */
+static bool
+resize (struct int_set *s, size_t slot_cnt)
+{
+  int *old_keys = s->keys;
+  int *old_values = s->values;
+  size_t old_slot_cnt = s->slot_cnt;
+  size_t i;
+
+  ASSERT (max_load (slot_cnt) >= s->key_cnt);
+
+  if (!alloc_slots (slot_cnt, old_values != NULL, &s->keys, &s->values))
+    {
+      s->keys = old_keys;
+      s->values = old_values;
+      return false;
+    }
+  s->slot_cnt = slot_cnt;
+
+  for (i = 0; i < old_slot_cnt; i++)
+    if (old_keys[i] != INT_SET_EMPTY)
+      {
+        size_t slot;
+
+        find_slot (s, old_keys[i], &slot);
+        s->keys[slot] = old_keys[i];
+        if (old_values != NULL)
+          s->values[slot] = old_values[i];
+      }
+
+  free (old_keys);
+  free (old_values);
+  return true;
+}
+
+/* Initializes S as empty, with room for values if WITH_VALUES.
+   Returns false if memory is exhausted. */
+static bool
+init (struct int_set *s, bool with_values)
+{
+  s->slot_cnt = MIN_SLOT_CNT;
+  s->min_slot_cnt = MIN_SLOT_CNT;
+  s->key_cnt = 0;
+  s->seed = (uint32_t) hash_new_seed ();
+  s->has_empty_key = false;
+  s->empty_key_value = 0;
+  return alloc_slots (s->slot_cnt, with_values, &s->keys, &s->values);
+}
+
+/* Finds KEY in S, adding it if it is absent, and returns its
+   slot: an index into `keys', EMPTY_KEY_SLOT for INT_SET_EMPTY,
+   or NO_SLOT if memory is exhausted.  Stores in *INSERTED
+   whether KEY was added. */
+static size_t
+add_key (struct int_set *s, int key, bool *inserted)
+{
+  size_t slot;
+
+  *inserted = false;
+  if (key == INT_SET_EMPTY)
+    {
+      *inserted = !s->has_empty_key;
+      s->has_empty_key = true;
+      return EMPTY_KEY_SLOT;
+    }
+
+  if (find_slot (s, key, &slot))
+    return slot;
+
+  /* Past the load limit, grow.  If that fails, keep filling the
+     slots we have, but always leave one empty, since it is what
+     ends an unsuccessful search. */
+  if (s->key_cnt + 1 > max_load (s->slot_cnt))
+    {
+      if (resize (s, s->slot_cnt * 2))
+        find_slot (s, key, &slot);
+      else if (s->key_cnt + 1 >= s->slot_cnt)
+        return NO_SLOT;
+    }
+
+  s->keys[slot] = key;
+  s->key_cnt++;
+  *inserted = true;
+  return slot;
+}
+
+/* Removes KEY from S.  Returns false if it was not there. */
+static bool
+remove_key (struct int_set *s, int key)
+{
+  size_t mask = s->slot_cnt - 1;
+  size_t i, j;
+
+  if (key == INT_SET_EMPTY)
+    {
+      bool had = s->has_empty_key;
+      s->has_empty_key = false;
+      return had;
+    }
+
+  if (!find_slot (s, key, &i))
+    return false;
+
+  /* Instead of leaving a tombstone, move back each later key of
+     the run whose home slot is not between the hole and it, so
+     that every key stays reachable from its home slot. */
+  for (j = (i + 1) & mask; s->keys[j] != INT_SET_EMPTY; j = (j + 1) & mask)
+    {
+      size_t home = home_slot (s, s->keys[j]);
+
+      if (((j - home) & mask) >= ((j - i) & mask))
+        {
+          s->keys[i] = s->keys[j];
+          if (s->values != NULL)
+            s->values[i] = s->values[j];
+          i = j;
+        }
+    }
+  s->keys[i] = INT_SET_EMPTY;
+  s->key_cnt--;
+
+  if (s->slot_cnt > s->min_slot_cnt && s->key_cnt < s->slot_cnt / 16)
+    resize (s, slot_cnt_for (s, s->key_cnt));
+  return true;
+}
+
+/* Advances *POS past the next slot of S in use, storing that
+   slot in *SLOT, and returns true, or returns false at the end.
+   Position 0 is the INT_SET_EMPTY key, and position I + 1 is
+   slot I. */
+static bool
+next_slot (const struct int_set *s, size_t *pos, size_t *slot)
+{
+  if (*pos == 0)
+    {
+      *pos = 1;
+      if (s->has_empty_key)
+        {
+          *slot = EMPTY_KEY_SLOT;
+          return true;
+        }
+    }
+
+  while (*pos <= s->slot_cnt)
+    {
+      size_t i = (*pos)++ - 1;
+
+      if (s->keys[i] != INT_SET_EMPTY)
+        {
+          *slot = i;
+          return true;
+        }
+    }
+  return false;
+}
+
+/* Initializes S as an empty set.  Returns false if memory is
+   exhausted. */
+bool
+int_set_init (struct int_set *s)
+{
+  ASSERT (s != NULL);
+
+  return init (s, false);
+}
+
+/* Frees the memory held by S. */
+void
+int_set_destroy (struct int_set *s)
+{
+  ASSERT (s != NULL);
+
+  free (s->keys);
+  free (s->values);
+  s->keys = s->values = NULL;
+}
+
+/* Removes all the keys from S, keeping its slots. */
+void
+int_set_clear (struct int_set *s)
+{
+  size_t i;
+
+  ASSERT (s != NULL);
+
+  for (i = 0; i < s->slot_cnt; i++)
+    s->keys[i] = INT_SET_EMPTY;
+  s->key_cnt = 0;
+  s->has_empty_key = false;
+}
+
+/* Adds KEY to S, if it is not there already.  Returns false if
+   memory is exhausted, true otherwise. */
+bool
+int_set_insert (struct int_set *s, int key)
+{
+  bool inserted;
+
+  ASSERT (s != NULL);
+
+  return add_key (s, key, &inserted) != NO_SLOT;
+}
+
+/* Returns true if KEY is in S. */
+bool
+int_set_contains (const struct int_set *s, int key)
+{
+  size_t slot;
+
+  ASSERT (s != NULL);
+
+  if (key == INT_SET_EMPTY)
+    return s->has_empty_key;
+  return find_slot (s, key, &slot);
+}
+
+/* Removes KEY from S.  Returns false if it was not there. */
+bool
+int_set_delete (struct int_set *s, int key)
+{
+  ASSERT (s != NULL);
+
+  return remove_key (s, key);
+}
+
+/* Replaces each key K of S by FUNC(K).  Keys that FUNC maps to
+   the same value become one.  Returns false, leaving S as it
+   was, if memory is exhausted.  Not for use on a map. */
+bool
+int_set_apply (struct int_set *s, int (*func) (int))
+{
+  struct int_set t;
+  size_t pos = 0;
+  int key;
+
+  ASSERT (s != NULL);
+  ASSERT (s->values == NULL);
+  ASSERT (func != NULL);
+
+  t.slot_cnt = s->slot_cnt;
+  t.min_slot_cnt = s->min_slot_cnt;
+  t.key_cnt = 0;
+  t.seed = s->seed;
+  t.has_empty_key = false;
+  t.empty_key_value = 0;
+  if (!alloc_slots (t.slot_cnt, false, &t.keys, &t.values))
+    return false;
+
+  while (int_set_next (s, &pos, &key))
+    if (!int_set_insert (&t, func (key)))
+      {
+        int_set_destroy (&t);
+        return false;
+      }
+
+  int_set_destroy (s);
+  *s = t;
+  return true;
+}
+
+/* Advances *POS, which starts out as 0, to the next key of S,
+   stores that key in *KEY, and returns true.  Returns false
+   after the last key. */
+bool
+int_set_next (const struct int_set *s, size_t *pos, int *key)
+{
+  size_t slot;
+
+  ASSERT (s != NULL);
+  ASSERT (pos != NULL);
+
+  if (!next_slot (s, pos, &slot))
+    return false;
+  *key = slot == EMPTY_KEY_SLOT ? INT_SET_EMPTY : s->keys[slot];
+  return true;
+}
+
+/* Makes room in S for at least KEY_CNT keys in all, so that
+   adding up to that many does not resize it, and keeps S from
+   shrinking below that size until int_set_shrink_to_fit() is
+   called.  Returns false if memory is exhausted, in which case S
+   is still usable. */
+bool
+int_set_reserve (struct int_set *s, size_t key_cnt)
+{
+  size_t slot_cnt;
+
+  ASSERT (s != NULL);
+
+  slot_cnt = slot_cnt_for (s, key_cnt);
+  if (slot_cnt > s->slot_cnt && !resize (s, slot_cnt))
+    return false;
+  if (slot_cnt > s->min_slot_cnt)
+    s->min_slot_cnt = slot_cnt;
+  return true;
+}
+
+/* Undoes any int_set_reserve() on S and shrinks it to the size
+   its keys call for. */
+void
+int_set_shrink_to_fit (struct int_set *s)
+{
+  size_t slot_cnt;
+
+  ASSERT (s != NULL);
+
+  s->min_slot_cnt = MIN_SLOT_CNT;
+  slot_cnt = slot_cnt_for (s, s->key_cnt);
+  if (slot_cnt < s->slot_cnt)
+    resize (s, slot_cnt);
+}
+
+/* Writes the keys of S to snapshot file FILE_NAME (see
+   snapshot.h), replacing any file of that name.  Returns false
+   if the file cannot be written. */
+bool
+int_set_save (const struct int_set *s, const char *file_name)
+{
+  struct snapshot_writer w;
+  size_t pos = 0;
+  int key;
+
+  ASSERT (s != NULL);
+
+  if (!snapshot_create (&w, file_name, int_set_size (s)))
+    return false;
+  while (int_set_next (s, &pos, &key))
+    snapshot_put (&w, key);
+  return snapshot_finish (&w);
+}
+
+/* Adds to S the keys in snapshot file FILE_NAME, written by
+   int_set_save() or hash_save().  The file is mapped rather than
+   read, and S is sized for all of its keys up front, so loading
+   never resizes S.  Returns false if the file cannot be mapped,
+   is not a valid snapshot, or memory is exhausted, in which case
+   S is unchanged. */
+bool
+int_set_load (struct int_set *s, const char *file_name)
+{
+  struct snapshot snap;
+  size_t min_slot_cnt;
+  bool inserted;
+  size_t i;
+
+  ASSERT (s != NULL);
+
+  if (!snapshot_map (&snap, file_name))
+    return false;
+
+  /* Reserve without pinning the size, as if S had been built one
+     insertion at a time. */
+  min_slot_cnt = s->min_slot_cnt;
+  if (!int_set_reserve (s, s->key_cnt + snap.value_cnt))
+    {
+      snapshot_unmap (&snap);
+      return false;
+    }
+  s->min_slot_cnt = min_slot_cnt;
+
+  for (i = 0; i < snap.value_cnt; i++)
+    add_key (s, snap.values[i], &inserted);
+
+  snapshot_unmap (&snap);
+  return true;
+}
+
+/* Returns the number of keys in S. */
+size_t
+int_set_size (const struct int_set *s)
+{
+  return s->key_cnt + s->has_empty_key;
+}
+
+/* Returns the number of slots in S. */
+size_t
+int_set_capacity (const struct int_set *s)
+{
+  return s->slot_cnt;
+}
+
+/* Initializes M as an empty map.  Returns false if memory is
+   exhausted. */
+bool
+int_map_init (struct int_map *m)
+{
+  ASSERT (m != NULL);
+
+  return init (&m->set, true);
+}
+
+/* Frees the memory held by M. */
+void
+int_map_destroy (struct int_map *m)
+{
+  int_set_destroy (&m->set);
+}
+
+/* Removes all the keys from M, keeping its slots. */
+void
+int_map_clear (struct int_map *m)
+{
+  int_set_clear (&m->set);
+}
+
+/* Maps KEY to VALUE in M, replacing any value KEY had.  Returns
+   false if memory is exhausted, true otherwise. */
+bool
+int_map_put (struct int_map *m, int key, int value)
+{
+  int *v = int_map_upsert (m, key, value);
+
+  if (v == NULL)
+    return false;
+  *v = value;
+  return true;
+}
+
+/* Returns a pointer to the value of KEY in M, first mapping KEY
+   to INIT if it is not in M, with a single search either way.
+   Returns a null pointer if memory is exhausted.  The pointer
+   is good until M is next modified:
+
+      int *cnt = int_map_upsert (&counts, word_id, 0);
+      if (cnt != NULL)
+        (*cnt)++; */
+int *
+int_map_upsert (struct int_map *m, int key, int init)
+{
+  struct int_set *s;
+  bool inserted;
+  size_t slot;
+  int *v;
+
+  ASSERT (m != NULL);
+
+  s = &m->set;
+  slot = add_key (s, key, &inserted);
+  if (slot == NO_SLOT)
+    return NULL;
+  v = slot == EMPTY_KEY_SLOT ? &s->empty_key_value : &s->values[slot];
+  if (inserted)
+    *v = init;
+  return v;
+}
+
+/* Stores KEY's value in M in *VALUE and returns true, or returns
+   false if KEY is not in M. */
+bool
+int_map_get (const struct int_map *m, int key, int *value)
+{
+  const struct int_set *s;
+  size_t slot;
+
+  ASSERT (m != NULL);
+
+  s = &m->set;
+  if (key == INT_SET_EMPTY)
+    {
+      if (s->has_empty_key)
+        *value = s->empty_key_value;
+      return s->has_empty_key;
+    }
+  if (!find_slot (s, key, &slot))
+    return false;
+  *value = s->values[slot];
+  return true;
+}
+
+/* Removes KEY and its value from M.  Returns false if it was not
+   there. */
+bool
+int_map_delete (struct int_map *m, int key)
+{
+  return remove_key (&m->set, key);
+}
+
+/* Like int_set_next(), for the keys of M, also storing the
+   key's value in *VALUE. */
+bool
+int_map_next (const struct int_map *m, size_t *pos, int *key, int *value)
+{
+  const struct int_set *s;
+  size_t slot;
+
+  ASSERT (m != NULL);
+  ASSERT (pos != NULL);
+
+  s = &m->set;
+  if (!next_slot (s, pos, &slot))
+    return false;
+  if (slot == EMPTY_KEY_SLOT)
+    {
+      *key = INT_SET_EMPTY;
+      *value = s->empty_key_value;
+    }
+  else
+    {
+      *key = s->keys[slot];
+      *value = s->values[slot];
+    }
+  return true;
+}
+
+/* Returns the number of keys in M. */
+size_t
+int_map_size (const struct int_map *m)
+{
+  return int_set_size (&m->set);
+}
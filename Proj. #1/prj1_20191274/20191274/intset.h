@@ -0,0 +1,102 @@
+#ifndef __MYLIB_INTSET_H
+#define __MYLIB_INTSET_H
+
+/* Flat integer set and map.
+
+   struct hash can hold anything, at a price: every element is a
+   separate struct hash_elem, reached through a bucket list or a
+   slot pointer, and every hash or comparison is a call through
+   a function pointer.  When the keys are plain ints, all of that
+   is overhead.
+
+   struct int_set keeps its keys inline, in one array of ints,
+   with linear probing: a key lives in the first free slot at or
+   after its home slot, so a lookup scans consecutive ints, often
+   within one cache line.  An unused slot holds the sentinel
+   INT_SET_EMPTY; the key INT_SET_EMPTY itself, which would be
+   mistaken for it, is kept aside in a flag.  Hashing (Fibonacci
+   hashing of the key) and comparison are inline, and deletion
+   shifts later keys back rather than leaving tombstones, so
+   lookups never slow down as keys come and go.  Each set XORs
+   its keys with a seed of its own from hash_new_seed() before
+   hashing them, so keys chosen to collide in one set do not
+   collide in another.
+
+   struct int_map is the same, with an int value next to each key
+   in a second array.
+
+      struct int_set set;
+
+      int_set_init (&set);
+      int_set_insert (&set, 42);
+      if (int_set_contains (&set, 42))
+        ...
+      int_set_destroy (&set);
+
+   Iteration visits the keys in no particular order:
+
+      size_t pos = 0;
+      int key;
+
+      while (int_set_next (&set, &pos, &key))
+        ...do something with key...
+
+   Modifying a set or map during iteration invalidates the
+   position. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "limits.h"
+
+/* Marks an unused slot. */
+#define INT_SET_EMPTY INT_MIN
+
+/* Flat integer set. */
+struct int_set
+  {
+    int *keys;                  /* `slot_cnt' keys or INT_SET_EMPTY. */
+    int *values;                /* Parallel values, for an int_map. */
+    size_t slot_cnt;            /* Number of slots, a power of 2. */
+    size_t min_slot_cnt;        /* Never shrink below this many. */
+    size_t key_cnt;             /* Keys in `keys' (not counting below). */
+    uint32_t seed;              /* Scrambles keys; see above. */
+    bool has_empty_key;         /* Is INT_SET_EMPTY in the set? */
+    int empty_key_value;        /* Its value, for an int_map. */
+  };
+
+/* Flat integer map. */
+struct int_map
+  {
+    struct int_set set;         /* Keys, plus values in `set.values'. */
+  };
+
+/* Sets. */
+bool int_set_init (struct int_set *);
+void int_set_destroy (struct int_set *);
+void int_set_clear (struct int_set *);
+bool int_set_insert (struct int_set *, int key);
+bool int_set_contains (const struct int_set *, int key);
+bool int_set_delete (struct int_set *, int key);
+bool int_set_apply (struct int_set *, int (*func) (int));
+bool int_set_next (const struct int_set *, size_t *pos, int *key);
+bool int_set_reserve (struct int_set *, size_t key_cnt);
+void int_set_shrink_to_fit (struct int_set *);
+size_t int_set_size (const struct int_set *);
+size_t int_set_capacity (const struct int_set *);
+bool int_set_save (const struct int_set *, const char *file_name);
+bool int_set_load (struct int_set *, const char *file_name);
+
+/* Maps. */
+bool int_map_init (struct int_map *);
+void int_map_destroy (struct int_map *);
+void int_map_clear (struct int_map *);
+bool int_map_put (struct int_map *, int key, int value);
+int *int_map_upsert (struct int_map *, int key, int init);
+bool int_map_get (const struct int_map *, int key, int *value);
+bool int_map_delete (struct int_map *, int key);
+bool int_map_next (const struct int_map *, size_t *pos,
+                   int *key, int *value);
+size_t int_map_size (const struct int_map *);
+
+#endif /* intset.h */
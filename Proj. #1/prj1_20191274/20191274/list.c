@@ -1,14 +1,18 @@
 #include "list.h"
 #include <assert.h>	
 #define ASSERT(CONDITION) assert(CONDITION)	
+#define UNUSED __attribute__ ((unused))
 
 // ---.
 /*
 This header file is for list_shuffle() (func()).
 */
 # include <stdlib.h>
-# include <time.h>
+# include "random.h"
 // ---.
+# include <string.h>
+# include <pthread.h>
+# include <unistd.h>
 
 /* Our doubly linked lists have two header elements: the "head"
    just before the first element and the "tail" just after the
@@ -493,6 +497,148 @@ list_sort (struct list *list, list_less_func *less, void *aux)
   ASSERT (is_sorted (list_begin (list), list_end (list), less, aux));
 }
 
+/* Work item for one thread of list_sort_parallel(): either sort
+   A, or merge B into A, which must both be sorted. */
+struct sort_job
+  {
+    struct list *a;             /* Segment sorted, or merged into. */
+    struct list *b;             /* Segment merged into A, or null. */
+    list_less_func *less;
+    void *aux;
+    pthread_t thread;
+    bool started;               /* Is THREAD running this job? */
+  };
+
+/* Runs JOB_ in the calling thread. */
+static void *
+run_sort_job (void *job_)
+{
+  struct sort_job *job = job_;
+
+  if (job->b == NULL)
+    list_sort (job->a, job->less, job->aux);
+  else if (!list_empty (job->b))
+    {
+      /* Append B to A, then merge the two runs in place.  On
+         ties inplace_merge() keeps A's element first, so the
+         merge is stable. */
+      struct list_elem *a1b0 = list_begin (job->b);
+
+      list_splice (list_end (job->a), a1b0, list_end (job->b));
+      inplace_merge (list_begin (job->a), a1b0, list_end (job->a),
+                     job->less, job->aux);
+    }
+  return NULL;
+}
+
+/* Runs the JOB_CNT jobs in JOBS concurrently and waits for all of
+   them.  A job whose thread can't be created runs in the calling
+   thread instead. */
+static void
+run_sort_jobs (struct sort_job *jobs, size_t job_cnt)
+{
+  size_t i;
+
+  for (i = 0; i < job_cnt; i++)
+    jobs[i].started = (i + 1 < job_cnt
+                       && pthread_create (&jobs[i].thread, NULL,
+                                          run_sort_job, &jobs[i]) == 0);
+  for (i = 0; i < job_cnt; i++)
+    if (!jobs[i].started)
+      run_sort_job (&jobs[i]);
+  for (i = 0; i < job_cnt; i++)
+    if (jobs[i].started)
+      pthread_join (jobs[i].thread, NULL);
+}
+
+/* Sorts LIST according to LESS given auxiliary data AUX, like
+   list_sort(), using up to THREAD_CNT threads.  A THREAD_CNT of 0
+   means one thread per online processor.
+
+   LIST is cut into THREAD_CNT contiguous segments, each segment
+   is sorted with list_sort() on its own thread, and neighboring
+   segments are then merged pairwise, each round of merges also
+   running in parallel, until one segment is left.  Because
+   segments are merged in order and every merge is stable, the
+   result is exactly the one list_sort() would produce.  LESS is
+   called from several threads at once, so it and AUX must be
+   safe to use that way.  Falls back on list_sort() for small
+   lists or if memory is short. */
+void
+list_sort_parallel (struct list *list, list_less_func *less, void *aux,
+                    size_t thread_cnt)
+{
+  struct list *segs;
+  struct sort_job *jobs;
+  size_t elem_cnt, seg_cnt, step, i;
+  struct list_elem *e;
+
+  ASSERT (list != NULL);
+  ASSERT (less != NULL);
+
+  if (thread_cnt == 0)
+    {
+      long cpu_cnt = sysconf (_SC_NPROCESSORS_ONLN);
+      thread_cnt = cpu_cnt > 0 ? (size_t) cpu_cnt : 1;
+    }
+
+  elem_cnt = list_size (list);
+  seg_cnt = thread_cnt < elem_cnt / 2 ? thread_cnt : elem_cnt / 2;
+  if (seg_cnt <= 1)
+    {
+      list_sort (list, less, aux);
+      return;
+    }
+
+  segs = malloc (sizeof *segs * seg_cnt);
+  jobs = malloc (sizeof *jobs * seg_cnt);
+  if (segs == NULL || jobs == NULL)
+    {
+      free (segs);
+      free (jobs);
+      list_sort (list, less, aux);
+      return;
+    }
+
+  /* Cut LIST into SEG_CNT segments of nearly equal size. */
+  e = list_begin (list);
+  for (i = 0; i < seg_cnt; i++)
+    {
+      size_t seg_size = elem_cnt / seg_cnt + (i < elem_cnt % seg_cnt);
+      struct list_elem *first = e;
+
+      while (seg_size-- > 0)
+        e = list_next (e);
+      list_init (&segs[i]);
+      list_splice (list_end (&segs[i]), first, e);
+    }
+
+  /* Sort the segments. */
+  for (i = 0; i < seg_cnt; i++)
+    jobs[i] = (struct sort_job) { .a = &segs[i], .b = NULL,
+                                  .less = less, .aux = aux };
+  run_sort_jobs (jobs, seg_cnt);
+
+  /* Merge neighbors, doubling the distance between them each
+     round: 0+1, 2+3, ...; then 0+2, 4+6, ...; and so on. */
+  for (step = 1; step < seg_cnt; step *= 2)
+    {
+      size_t job_cnt = 0;
+
+      for (i = 0; i + step < seg_cnt; i += 2 * step)
+        jobs[job_cnt++] = (struct sort_job) { .a = &segs[i],
+                                              .b = &segs[i + step],
+                                              .less = less, .aux = aux };
+      run_sort_jobs (jobs, job_cnt);
+    }
+
+  list_splice (list_end (list), list_begin (&segs[0]), list_end (&segs[0]));
+  free (segs);
+  free (jobs);
+
+  ASSERT (is_sorted (list_begin (list), list_end (list), less, aux));
+}
+
 /* Inserts ELEM in the proper position in LIST, which must be
    sorted according to LESS given auxiliary data AUX.
    Runs in O(n) average case in the number of elements in LIST. */
@@ -542,6 +688,32 @@ list_unique (struct list *list, struct list *duplicates,
       elem = next;
 }
 
+/* Like list_unique(), but decides whether adjacent elements are
+   equal with a single call to EQ given auxiliary data AUX,
+   instead of two calls to a `less' function. */
+void
+list_unique_eq (struct list *list, struct list *duplicates,
+                list_eq_func *eq, void *aux)
+{
+  struct list_elem *elem, *next;
+
+  ASSERT (list != NULL);
+  ASSERT (eq != NULL);
+  if (list_empty (list))
+    return;
+
+  elem = list_begin (list);
+  while ((next = list_next (elem)) != list_end (list))
+    if (eq (elem, next, aux))
+      {
+        list_remove (next);
+        if (duplicates != NULL)
+          list_push_back (duplicates, next);
+      }
+    else
+      elem = next;
+}
+
 /* Returns the element in LIST with the largest value according
    to LESS given auxiliary data AUX.  If there is more than one
    maximum, returns the one that appears earlier in the list.  If
@@ -588,10 +760,6 @@ list_min (struct list *list, list_less_func *less, void *aux)
 *********************************************************************
 */
 void list_shuffle(struct list* list) {
-    // for accurate(?) randomization.
-    static int cnt = 20191274;
-    cnt++;
-
     // As you know, 
     // First, we should do exceptionHandling.
     /*
@@ -641,27 +809,25 @@ void list_shuffle(struct list* list) {
     https://daheenallwhite.github.io/programming/algorithm/2019/06/27/Shuffle-Algorithm-Fisher-Yates/
 
     */
-    // srand(time(NULL)); // set seedNumber. ==>> Nope...
+    // Only the array is permuted here; the list is relinked once, in Step3.
+    // random_bounded() is unbiased, unlike rand() % (i + 1),
+    // and the sequence is fixed by random_init()'s seed, so a run can be replayed.
+    for (size_t i = sizeOfList - 1; i >= 1; i--) {
+        size_t j = (size_t)random_bounded((uint64_t)i + 1);
 
-    srand(time(NULL) + (time_t)cnt);
+        swap(&arrayAboutListElem[i], &arrayAboutListElem[j]);
+    }
 
-    struct list_elem* tmp;
-    for (int i = sizeOfList - 1; i >= 1; i--) {
-        int j = rand() % (i + 1);
-        // Then exchage arr[j] and arr[i].
+    // Step3. Relink the list in the order of arrayAboutListElem.
+    struct list_elem* prevListElem = list_head(list);
+    for (size_t idx = 0; idx < sizeOfList; idx++) {
+        prevListElem->next = arrayAboutListElem[idx];
+        arrayAboutListElem[idx]->prev = prevListElem;
 
-        // i° Address j° Address Shuffle.
-        // , list_swap() func()Call Ͽ,  list ġ Exchage .
-        list_swap(arrayAboutListElem[i], arrayAboutListElem[j]);
-        // ״, arrayAboutListElem Exchage־ .
-        /*
-        tmp = arrayAboutListElem[i];
-        arrayAboutListElem[i] = arrayAboutListElem[j];
-        arrayAboutListElem[j] = tmp;
-        */
-        // Modularization? ==>> Readability ?
-        swap(&arrayAboutListElem[i], &arrayAboutListElem[j]);
+        prevListElem = arrayAboutListElem[idx];
     }
+    prevListElem->next = list_tail(list);
+    list_tail(list)->prev = prevListElem;
 
     /* Warning: Don't forget memoryDeallocation. */
     free(arrayAboutListElem);
@@ -769,4 +935,117 @@ void list_swap(struct list_elem* elem1, struct list_elem* elem2) {
         */
     }
 }
-// ---.
\ No newline at end of file
+// ---.
+
+/* One element of the array list_radix_sort() sorts: the key of
+   a `struct list_item' and the element itself, side by side, so
+   the sort never has to chase list pointers. */
+struct radix_slot
+  {
+    uint32_t key;               /* DATA, biased so it sorts unsigned. */
+    struct list_elem *elem;     /* Element carrying that DATA. */
+  };
+
+/* Number of bits sorted per pass, and buckets per pass. */
+#define RADIX_BITS 8
+#define RADIX_SIZE (1 << RADIX_BITS)
+#define RADIX_PASSES (32 / RADIX_BITS)
+
+/* Orders two `struct list_item's by DATA.
+   list_radix_sort() falls back on list_sort() with this. */
+static bool
+item_less (const struct list_elem *a, const struct list_elem *b,
+           void *aux UNUSED)
+{
+  return list_entry (a, struct list_item, elem)->data
+         < list_entry (b, struct list_item, elem)->data;
+}
+
+/********************************************************************
+- Functionality : Sort LIST, whose elements must all be embedded in
+                  `struct list_item's, in nondecreasing order of DATA.
+                  The result is the same as list_sort() with a `<'
+                  comparison on DATA, equal elements included (stable).
+- Parameter     : Pointer of list that will be sorted.
+- Return value  : None.
+*********************************************************************
+*/
+/* Instead of merging runs of list elements, the keys and element
+   pointers are copied into a contiguous array, sorted there by an
+   LSD radix sort (one counting pass per byte of the key, skipping
+   bytes all keys share), and the list is relinked in one final
+   pass.  That is O(n) time and O(n) extra space, and touches each
+   list element only twice.  If the array can't be allocated,
+   falls back on list_sort(). */
+void list_radix_sort(struct list* list) {
+    size_t count[RADIX_PASSES][RADIX_SIZE];
+    struct radix_slot *slots, *tmp;
+    struct list_elem *e, *prev;
+    size_t n, i;
+    int pass;
+
+    ASSERT (list != NULL);
+
+    n = list_size (list);
+    if (n <= 1)
+        return;
+
+    slots = malloc (sizeof *slots * n * 2);
+    if (slots == NULL) {
+        list_sort (list, item_less, NULL);
+        return;
+    }
+    tmp = slots + n;
+
+    // Step1. Gather keys, and count every digit in the same pass.
+    memset (count, 0, sizeof count);
+    for (e = list_begin (list), i = 0; e != list_end (list); e = list_next (e), i++) {
+        /* Flipping the sign bit makes signed order unsigned order. */
+        uint32_t key = (uint32_t) list_entry (e, struct list_item, elem)->data
+                       ^ 0x80000000u;
+
+        slots[i].key = key;
+        slots[i].elem = e;
+        for (pass = 0; pass < RADIX_PASSES; pass++)
+            count[pass][(key >> (pass * RADIX_BITS)) & (RADIX_SIZE - 1)]++;
+    }
+
+    // Step2. One stable counting sort per digit, least significant first.
+    for (pass = 0; pass < RADIX_PASSES; pass++) {
+        const int shift = pass * RADIX_BITS;
+        size_t *c = count[pass];
+        size_t sum = 0;
+        struct radix_slot *t;
+        int d;
+
+        // Every key has the same digit here, so the pass would not reorder anything.
+        if (c[(slots[0].key >> shift) & (RADIX_SIZE - 1)] == n)
+            continue;
+
+        for (d = 0; d < RADIX_SIZE; d++) {
+            size_t cnt = c[d];
+            c[d] = sum;
+            sum += cnt;
+        }
+        for (i = 0; i < n; i++)
+            tmp[c[(slots[i].key >> shift) & (RADIX_SIZE - 1)]++] = slots[i];
+
+        t = slots;
+        slots = tmp;
+        tmp = t;
+    }
+
+    // Step3. Relink the list in sorted order.
+    prev = list_head (list);
+    for (i = 0; i < n; i++) {
+        prev->next = slots[i].elem;
+        slots[i].elem->prev = prev;
+        prev = slots[i].elem;
+    }
+    prev->next = list_tail (list);
+    list_tail (list)->prev = prev;
+
+    /* Warning: Don't forget memoryDeallocation. */
+    free (slots < tmp ? slots : tmp);
+}
+// ---.
@@ -174,13 +174,23 @@ typedef bool list_less_func (const struct list_elem *a,
                              const struct list_elem *b,
                              void *aux);
 
+/* Returns true if list elements A and B are equal, given
+   auxiliary data AUX. */
+typedef bool list_eq_func (const struct list_elem *a,
+                           const struct list_elem *b,
+                           void *aux);
+
 /* Operations on lists with ordered elements. */
 void list_sort (struct list *,
                 list_less_func *, void *aux);
+void list_sort_parallel (struct list *,
+                         list_less_func *, void *aux, size_t thread_cnt);
 void list_insert_ordered (struct list *, struct list_elem *,
                           list_less_func *, void *aux);
 void list_unique (struct list *, struct list *duplicates,
                   list_less_func *, void *aux);
+void list_unique_eq (struct list *, struct list *duplicates,
+                     list_eq_func *, void *aux);
 
 /* Max and min. */
 struct list_elem *list_max (struct list *, list_less_func *, void *aux);
@@ -189,6 +199,7 @@ struct list_elem *list_min (struct list *, list_less_func *, void *aux);
 // --- SP Prj. #1. ---.
 void list_shuffle(struct list* list);
 void list_swap(struct list_elem* elem1, struct list_elem* elem2);
+void list_radix_sort(struct list* list);
 // -------------------.
 
 #endif /* list.h */
@@ -0,0 +1,433 @@
+/* Positional index over a doubly linked list.
+
+See list_index.h for basic information. */
+
+#include "list_index.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define ASSERT(CONDITION) assert(CONDITION)
+
+/* Treap node.  The in-order sequence of the nodes is the order
+   of the elements in the list, so a node's position is the
+   number of nodes to its left; there is no explicit key. */
+struct list_index_node
+  {
+    struct list_index_node *left;       /* Elements before this one. */
+    struct list_index_node *right;      /* Elements after this one. */
+    struct list_elem *elem;             /* The indexed list element. */
+    size_t size;                        /* Nodes in this subtree. */
+    uint32_t priority;                  /* Max-heap ordered. */
+  };
+
+static bool refresh (struct list_index *);
+
+/* Returns a pseudo-random treap priority (xorshift32). */
+static uint32_t
+next_priority (void)
+{
+  static uint32_t state = 2463534242u;
+
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+/* Returns the number of nodes in the subtree rooted at N. */
+static inline size_t
+node_size (const struct list_index_node *n)
+{
+  return n != NULL ? n->size : 0;
+}
+
+/* Recomputes N's subtree size from its children. */
+static inline void
+update (struct list_index_node *n)
+{
+  n->size = 1 + node_size (n->left) + node_size (n->right);
+}
+
+/* Allocates a node for ELEM.  Returns a null pointer if memory
+   is exhausted. */
+static struct list_index_node *
+new_node (struct list_elem *elem)
+{
+  struct list_index_node *n = malloc (sizeof *n);
+  if (n != NULL)
+    {
+      n->left = n->right = NULL;
+      n->elem = elem;
+      n->size = 1;
+      n->priority = next_priority ();
+    }
+  return n;
+}
+
+/* Frees every node in the subtree rooted at N. */
+static void
+free_tree (struct list_index_node *n)
+{
+  while (n != NULL)
+    {
+      struct list_index_node *right = n->right;
+      free_tree (n->left);
+      free (n);
+      n = right;
+    }
+}
+
+/* Concatenates trees A and B, every node of A coming before
+   every node of B, and returns the root of the result. */
+static struct list_index_node *
+merge (struct list_index_node *a, struct list_index_node *b)
+{
+  if (a == NULL)
+    return b;
+  if (b == NULL)
+    return a;
+
+  if (a->priority > b->priority)
+    {
+      a->right = merge (a->right, b);
+      update (a);
+      return a;
+    }
+  else
+    {
+      b->left = merge (a, b->left);
+      update (b);
+      return b;
+    }
+}
+
+/* Splits tree T into *A, holding its first POS nodes, and *B,
+   holding the rest. */
+static void
+split (struct list_index_node *t, size_t pos,
+       struct list_index_node **a, struct list_index_node **b)
+{
+  if (t == NULL)
+    {
+      *a = *b = NULL;
+      return;
+    }
+
+  if (node_size (t->left) < pos)
+    {
+      split (t->right, pos - node_size (t->left) - 1, &t->right, b);
+      update (t);
+      *a = t;
+    }
+  else
+    {
+      split (t->left, pos, a, &t->left);
+      update (t);
+      *b = t;
+    }
+}
+
+/* Returns the node at position POS in tree T, which must have
+   more than POS nodes. */
+static struct list_index_node *
+find_node (struct list_index_node *t, size_t pos)
+{
+  ASSERT (pos < node_size (t));
+
+  for (;;)
+    {
+      size_t left_size = node_size (t->left);
+
+      if (pos < left_size)
+        t = t->left;
+      else if (pos == left_size)
+        return t;
+      else
+        {
+          pos -= left_size + 1;
+          t = t->right;
+        }
+    }
+}
+
+/* Recomputes all subtree sizes below N, bottom up. */
+static size_t
+fix_sizes (struct list_index_node *n)
+{
+  if (n == NULL)
+    return 0;
+  n->size = 1 + fix_sizes (n->left) + fix_sizes (n->right);
+  return n->size;
+}
+
+/* Returns the element at POS in LIST by walking it from the
+   front.  Used only when the index could not be built. */
+static struct list_elem *
+walk (struct list *list, size_t pos)
+{
+  struct list_elem *e = list_begin (list);
+
+  while (pos-- > 0)
+    e = list_next (e);
+  return e;
+}
+
+/* Initializes IX as a positional index over LIST, which may
+   already contain elements.  The index itself is built lazily,
+   by the first positional operation. */
+void
+list_index_init (struct list_index *ix, struct list *list)
+{
+  ASSERT (ix != NULL);
+  ASSERT (list != NULL);
+
+  ix->list = list;
+  ix->root = NULL;
+  ix->stale = true;
+}
+
+/* Frees the memory held by IX.  The list itself and its
+   elements are left untouched. */
+void
+list_index_destroy (struct list_index *ix)
+{
+  ASSERT (ix != NULL);
+
+  free_tree (ix->root);
+  ix->root = NULL;
+  ix->stale = true;
+}
+
+/* Tells IX that its list was modified by something other than
+   the list_index_* functions.  The index is rebuilt the next
+   time it is needed. */
+void
+list_index_invalidate (struct list_index *ix)
+{
+  ASSERT (ix != NULL);
+
+  ix->stale = true;
+}
+
+/* Rebuilds IX from its list in O(n) time.  The nodes are
+   linked into a treap with the usual stack-based Cartesian tree
+   construction.  If memory runs out the index stays stale and
+   positional operations fall back to walking the list. */
+void
+list_index_rebuild (struct list_index *ix)
+{
+  struct list_index_node **spine;
+  size_t n, depth;
+  struct list_elem *e;
+
+  ASSERT (ix != NULL);
+
+  free_tree (ix->root);
+  ix->root = NULL;
+  ix->stale = true;
+
+  n = list_size (ix->list);
+  if (n == 0)
+    {
+      ix->stale = false;
+      return;
+    }
+
+  /* SPINE holds the right spine of the tree built so far. */
+  spine = malloc (sizeof *spine * n);
+  if (spine == NULL)
+    return;
+
+  depth = 0;
+  for (e = list_begin (ix->list); e != list_end (ix->list); e = list_next (e))
+    {
+      struct list_index_node *node = new_node (e);
+      struct list_index_node *last = NULL;
+
+      if (node == NULL)
+        {
+          if (depth > 0)
+            free_tree (spine[0]);
+          free (spine);
+          return;
+        }
+
+      while (depth > 0 && spine[depth - 1]->priority < node->priority)
+        last = spine[--depth];
+      node->left = last;
+      if (depth > 0)
+        spine[depth - 1]->right = node;
+      spine[depth++] = node;
+    }
+
+  ix->root = spine[0];
+  fix_sizes (ix->root);
+  ix->stale = false;
+  free (spine);
+}
+
+/* Rebuilds IX if it is stale.  Returns true if the index is
+   usable afterward. */
+static bool
+refresh (struct list_index *ix)
+{
+  if (ix->stale)
+    list_index_rebuild (ix);
+  return !ix->stale;
+}
+
+/* Returns the number of elements in IX's list. */
+size_t
+list_index_size (struct list_index *ix)
+{
+  ASSERT (ix != NULL);
+
+  if (!refresh (ix))
+    return list_size (ix->list);
+  return node_size (ix->root);
+}
+
+/* Returns the element at position POS in IX's list, or the list
+   tail if POS equals the number of elements.  Runs in O(log n)
+   expected time. */
+struct list_elem *
+list_at (struct list_index *ix, size_t pos)
+{
+  ASSERT (ix != NULL);
+
+  if (!refresh (ix))
+    return walk (ix->list, pos);
+
+  ASSERT (pos <= node_size (ix->root));
+  if (pos == node_size (ix->root))
+    return list_end (ix->list);
+  return find_node (ix->root, pos)->elem;
+}
+
+/* Inserts ELEM so that it becomes the element at position POS
+   in IX's list.  POS may equal the number of elements, which is
+   equivalent to list_push_back(). */
+void
+list_index_insert (struct list_index *ix, size_t pos, struct list_elem *elem)
+{
+  struct list_index_node *node, *a, *b;
+
+  ASSERT (ix != NULL);
+  ASSERT (elem != NULL);
+
+  list_insert (list_at (ix, pos), elem);
+  if (ix->stale)
+    return;
+
+  node = new_node (elem);
+  if (node == NULL)
+    {
+      ix->stale = true;
+      return;
+    }
+  split (ix->root, pos, &a, &b);
+  ix->root = merge (merge (a, node), b);
+}
+
+/* Removes the element at position POS from IX's list and
+   returns it.  POS must be less than the number of elements. */
+struct list_elem *
+list_index_remove (struct list_index *ix, size_t pos)
+{
+  struct list_index_node *a, *m, *b;
+  struct list_elem *elem;
+
+  ASSERT (ix != NULL);
+
+  if (!refresh (ix))
+    {
+      elem = walk (ix->list, pos);
+      list_remove (elem);
+      return elem;
+    }
+
+  ASSERT (pos < node_size (ix->root));
+  split (ix->root, pos, &a, &b);
+  split (b, 1, &m, &b);
+  ix->root = merge (a, b);
+
+  elem = m->elem;
+  free (m);
+  list_remove (elem);
+  return elem;
+}
+
+/* Removes the elements at positions FIRST through LAST
+   (exclusive) from SRC's list and inserts them so that the first
+   of them lands at position POS of DST's list, like
+   list_splice().  SRC and DST may be the same index, in which
+   case POS must lie outside FIRST...LAST; it is interpreted
+   against the list before the move, the way list_splice()
+   interprets its BEFORE element. */
+void
+list_index_splice (struct list_index *dst, size_t pos,
+                   struct list_index *src, size_t first, size_t last)
+{
+  struct list_index_node *a, *m, *b;
+  struct list_elem *before;
+
+  ASSERT (dst != NULL);
+  ASSERT (src != NULL);
+  ASSERT (first <= last);
+  ASSERT (dst != src || pos <= first || pos >= last);
+
+  if (first == last || (dst == src && (pos == first || pos == last)))
+    return;
+
+  before = list_at (dst, pos);
+  list_splice (before, list_at (src, first), list_at (src, last));
+  if (dst->stale || src->stale)
+    {
+      dst->stale = src->stale = true;
+      return;
+    }
+
+  split (src->root, first, &a, &b);
+  split (b, last - first, &m, &b);
+  src->root = merge (a, b);
+
+  if (dst == src && pos >= last)
+    pos -= last - first;
+  split (dst->root, pos, &a, &b);
+  dst->root = merge (merge (a, m), b);
+}
+
+/* Swaps the elements at positions POS1 and POS2 in IX's list,
+   like list_swap(). */
+void
+list_index_swap (struct list_index *ix, size_t pos1, size_t pos2)
+{
+  struct list_index_node *n1, *n2;
+  struct list_elem *t;
+
+  ASSERT (ix != NULL);
+
+  if (pos1 == pos2)
+    return;
+  if (pos1 > pos2)
+    {
+      size_t tmp = pos1;
+      pos1 = pos2;
+      pos2 = tmp;
+    }
+
+  if (!refresh (ix))
+    {
+      list_swap (walk (ix->list, pos1), walk (ix->list, pos2));
+      return;
+    }
+
+  n1 = find_node (ix->root, pos1);
+  n2 = find_node (ix->root, pos2);
+  list_swap (n1->elem, n2->elem);
+
+  t = n1->elem;
+  n1->elem = n2->elem;
+  n2->elem = t;
+}
@@ -0,0 +1,59 @@
+#ifndef __MYLIB_LIST_INDEX_H
+#define __MYLIB_LIST_INDEX_H
+
+/* Positional index over a doubly linked list.
+
+   A plain `struct list' can only reach its Nth element by
+   walking N links from the front.  A list_index keeps, next to
+   the list, an implicit treap (a randomized balanced binary tree
+   whose in-order sequence is the list order, with every node
+   holding the size of its subtree).  That makes list_at() and
+   the positional insert, remove, splice and swap operations
+   below run in O(log n) expected time.
+
+   The index does not change the list itself: every list_*
+   function still works on an indexed list.  Changes made through
+   the list_index_* functions keep both structures in sync.  If
+   the list is modified some other way (list_sort(),
+   list_push_back(), ...), call list_index_invalidate(); the next
+   positional operation then rebuilds the index in O(n).
+
+      struct list foo_list;
+      struct list_index foo_index;
+
+      list_init (&foo_list);
+      list_index_init (&foo_index, &foo_list);
+      list_index_insert (&foo_index, 0, &foo->elem);
+      e = list_at (&foo_index, 0);
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "list.h"
+
+struct list_index_node;
+
+/* Positional index. */
+struct list_index
+  {
+    struct list *list;                  /* Indexed list. */
+    struct list_index_node *root;       /* Treap over LIST's elements. */
+    bool stale;                         /* LIST changed behind our back? */
+  };
+
+/* Life cycle. */
+void list_index_init (struct list_index *, struct list *);
+void list_index_destroy (struct list_index *);
+void list_index_invalidate (struct list_index *);
+void list_index_rebuild (struct list_index *);
+
+/* Positional access and modification. */
+size_t list_index_size (struct list_index *);
+struct list_elem *list_at (struct list_index *, size_t pos);
+void list_index_insert (struct list_index *, size_t pos, struct list_elem *);
+struct list_elem *list_index_remove (struct list_index *, size_t pos);
+void list_index_splice (struct list_index *dst, size_t pos,
+                        struct list_index *src, size_t first, size_t last);
+void list_index_swap (struct list_index *, size_t pos1, size_t pos2);
+
+#endif /* list_index.h */
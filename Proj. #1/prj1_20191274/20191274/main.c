@@ -22,24 +22,69 @@ Here are Assumptions.
 # include <time.h>
 
 # include "list.h"
+# include "list_index.h"
 # include "bitmap.h"
 # include "hash.h"
+# include "btree.h"
+# include "intset.h"
+# include "cache.h"
+# include "chash.h"
 # include "round.h"
+# include "slab.h"
+# include "random.h"
+# include "limits.h"
 
 # define MAX_LIST_CNT 10
 # define MAX_HASHMAP_CNT 10
 # define MAX_BITMAP_CNT 10
+# define MAX_BTREE_CNT 10
+# define MAX_CACHE_CNT 10
+# define MAX_CHASH_CNT 10
 
 # define HASH_FIND_ERROR -20191274
 
+# define SLAB_CHUNK_OBJS 1024 // Nodes carved out of each malloc() by a slab.
+
 char input[128];
 char words[8][32];
 
 struct list* lists[MAX_LIST_CNT];
+struct list_index listIndexes[MAX_LIST_CNT]; // Positional index of lists[idx].
+/*
+Every list_item comes from this one slab.
+list_splice() and list_unique() move items from one list to another, 
+so the items of a list can't have a slab of their own.
+*/
+struct slab listItemSlab;
 
 struct bitmap* bitmaps[MAX_BITMAP_CNT];
 
 struct hash* hashmaps[MAX_HASHMAP_CNT];
+struct slab hashElemSlabs[MAX_HASHMAP_CNT]; // hash_elem's of hashmaps[idx].
+struct int_set* intSets[MAX_HASHMAP_CNT]; // Flat tables. hashN is either hashmaps[N] or intSets[N].
+
+struct btree* btrees[MAX_BTREE_CNT];
+
+// An int stored in a btree.
+struct btreeEntry {
+	struct btree_elem elem;
+	int value;
+};
+
+struct slab btreeEntrySlabs[MAX_BTREE_CNT]; // btreeEntry's of btrees[idx].
+
+// A cached key -> value pair.
+struct cacheEntry {
+	struct cache_elem elem;
+	int key;
+	int value;
+};
+
+struct cache* caches[MAX_CACHE_CNT];
+struct slab cacheEntrySlabs[MAX_CACHE_CNT]; // cacheEntry's of caches[idx].
+
+struct chash* chashes[MAX_CHASH_CNT];
+struct slab chashElemSlabs[MAX_CHASH_CNT]; // hash_elem's of chashes[idx]. testlib runs on one thread, so a slab will do.
 
 /* ---. */
 /*
@@ -87,6 +132,12 @@ const bool less
 	return elem1Data < elem2Data;
 }
 
+// This is about equalFunc(), for list_unique_eq().
+const bool equal
+(const struct list_elem* elem1, const struct list_elem* elem2, void* aux) {
+	return list_entry(elem1, struct list_item, elem)->data == list_entry(elem2, struct list_item, elem)->data;
+}
+
 // (ex. create list list0 && etc.).
 void createL(char* name) {
 	int idx = atoi(name + 4);
@@ -104,6 +155,24 @@ void createL(char* name) {
 	lists[idx] = tmp; tmp = NULL;
 
 	list_init(lists[idx]);
+	list_index_init(&listIndexes[idx], lists[idx]);
+}
+
+struct list_item* makeListItem(void) {
+	struct list_item* temp = slab_alloc(&listItemSlab);
+	if (temp == NULL) {
+		signal();
+	}
+	
+	temp->elem.prev = NULL;
+	temp->elem.next = NULL;
+	temp->data = 0;
+
+	return temp;
+}
+
+void freeListItem(struct list_item* item) {
+	slab_free(&listItemSlab, item);
 }
 
 // (ex. delete list0)
@@ -124,6 +193,8 @@ void deleteL(char* name) {
 		lists[idx]->tail = NULL;
 		*/
 
+		list_index_destroy(&listIndexes[idx]);
+
 		free(lists[idx]);
 		lists[idx] = NULL;
 
@@ -131,11 +202,19 @@ void deleteL(char* name) {
 	}
 
 	// If list is not empty.
-	struct list_elem* iter = list_begin(lists[idx]);
-	for (; iter != list_end(lists[idx]); iter = list_remove(iter));
+	while (!list_empty(lists[idx])) {
+		freeListItem(list_entry(list_pop_front(lists[idx]), struct list_item, elem));
+	}
+
+	list_index_destroy(&listIndexes[idx]);
 
 	free(lists[idx]);
 	lists[idx] = NULL;
+
+	// If no list_item is left at all, give the slab's memory back in bulk.
+	if (slab_used(&listItemSlab) == 0) {
+		slab_release(&listItemSlab);
+	}
 }
 
 void dumpdataL(char* name) {
@@ -156,19 +235,6 @@ void dumpdataL(char* name) {
 	printf("\n");
 }
 
-struct list_item* makeListItem(void) {
-	struct list_item* temp = malloc(sizeof(struct list_item) * 1);
-	if (temp == NULL) {
-		signal();
-	}
-	
-	temp->elem.prev = NULL;
-	temp->elem.next = NULL;
-	temp->data = 0;
-
-	return temp;
-}
-
 /*
 if option == 0, then list_push_back() Call.
 if option == 1, then list_push_front() Call.
@@ -183,11 +249,12 @@ void pushL(char* name, int data, int option) {
 	struct list_item* temp = makeListItem();
 	temp->data = data;
 
+	// Go through the index, so that it stays in sync with the list.
 	if (option == 0) {
-		list_push_back(lists[idx], &temp->elem);
+		list_index_insert(&listIndexes[idx], list_index_size(&listIndexes[idx]), &temp->elem);
 	}
 	else if (option == 1) {
-		list_push_front(lists[idx], &temp->elem);
+		list_index_insert(&listIndexes[idx], 0, &temp->elem);
 	}
 }
 
@@ -208,11 +275,16 @@ void popL(char* name, int option) {
 		return;
 	}
 
+	struct list_elem* popped = NULL;
 	if (option == 0) {
-		list_pop_back(lists[idx]);
+		popped = list_index_remove(&listIndexes[idx], list_index_size(&listIndexes[idx]) - 1);
 	}
 	else if (option == 1) {
-		list_pop_front(lists[idx]);
+		popped = list_index_remove(&listIndexes[idx], 0);
+	}
+
+	if (popped != NULL) {
+		freeListItem(list_entry(popped, struct list_item, elem));
 	}
 }
 
@@ -262,15 +334,15 @@ void insertL(char* name, int insertIdx, int data) {
 		return;
 	}
 
+	if (insertIdx < 0 || insertIdx > list_index_size(&listIndexes[idx])) {
+		return;
+	}
+
 	struct list_item* temp = makeListItem();
 	temp->data = data;
 
-	struct list_elem* iter = list_begin(lists[idx]);
-	for (int cnt = 0; cnt < insertIdx; cnt++) {
-		iter = list_next(iter);
-	}
-
-	list_insert(iter, &temp->elem);
+	// O(log n) by list_index, instead of walking insertIdx elements.
+	list_index_insert(&listIndexes[idx], insertIdx, &temp->elem);
 }
 
 // (ex. list_insert_ordered list0 5 && etc.).
@@ -285,6 +357,7 @@ void insertOrderedL(char* name, int data) {
 	temp->data = data;
 
 	list_insert_ordered(lists[idx], &temp->elem, less, NULL);
+	list_index_invalidate(&listIndexes[idx]);
 }
 
 // (ex. list_remove list0 2 && etc.).
@@ -305,12 +378,12 @@ void removeL(char* name, int removeIdx) {
 		return;
 	}
 
-	struct list_elem* iter = list_begin(lists[idx]);
-	for (int cnt = 0; cnt < removeIdx; cnt++) {
-		iter = list_next(iter);
+	if (removeIdx < 0 || removeIdx >= list_index_size(&listIndexes[idx])) {
+		return;
 	}
 
-	list_remove(iter);
+	struct list_elem* removed = list_index_remove(&listIndexes[idx], removeIdx);
+	freeListItem(list_entry(removed, struct list_item, elem));
 }
 
 /*
@@ -333,21 +406,21 @@ void spliceL (char* destName, int destIdx,
 		return;
 	}
 
-	struct list_elem* sourceListElemFirst = list_begin(lists[sourceListIdx]);
-	for (int cnt = 0; cnt < sourceIdx1; cnt++) {
-		sourceListElemFirst = list_next(sourceListElemFirst);
+	struct list_index* dest = &listIndexes[destListIdx];
+	struct list_index* source = &listIndexes[sourceListIdx];
+
+	if (sourceIdx1 < 0 || sourceIdx1 > sourceIdx2 || sourceIdx2 > list_index_size(source)) {
+		return;
 	}
-	struct list_elem* sourceListElemLast = list_begin(lists[sourceListIdx]);
-	for (int cnt = 0; cnt < sourceIdx2; cnt++) {
-		sourceListElemLast = list_next(sourceListElemLast);
+	if (destIdx < 0 || destIdx > list_index_size(dest)) {
+		return;
 	}
-
-	struct list_elem* destListElemBefore = list_begin(lists[destListIdx]);
-	for (int cnt = 0; cnt < destIdx; cnt++) {
-		destListElemBefore = list_next(destListElemBefore);
+	// Splicing a range in front of one of its own elements is meaningless.
+	if (dest == source && destIdx > sourceIdx1 && destIdx < sourceIdx2) {
+		return;
 	}
 
-	list_splice(destListElemBefore, sourceListElemFirst, sourceListElemLast);
+	list_index_splice(dest, destIdx, source, sourceIdx1, sourceIdx2);
 }
 
 const size_t maxL(char* name, bool* successFlag) {
@@ -438,7 +511,7 @@ const size_t sizeL(char* name) {
 		return (size_t)0;
 	}
 
-	return list_size(lists[idx]);
+	return list_index_size(&listIndexes[idx]);
 }
 
 void shuffleL(char* name) {
@@ -449,6 +522,18 @@ void shuffleL(char* name) {
 	}
 
 	list_shuffle(lists[idx]);
+	list_index_invalidate(&listIndexes[idx]);
+}
+
+/*
+Reseeds list_shuffle()'s generator, and the seeds of the hash tables created from now on.
+The same seed and the same commands give the same shuffles and the same dumpdata order.
+*/
+void shuffleSeedL(char* seedStr) {
+	const uint64_t seed = (uint64_t)strtoull(seedStr, NULL, 10);
+
+	random_init(seed);
+	hash_set_seed(seed);
 }
 
 void sortL(char* name) {
@@ -458,7 +543,25 @@ void sortL(char* name) {
 		return;
 	}
 
-	list_sort(lists[idx], less, NULL);
+	// list_item's are int-keyed, so radix sort them instead of list_sort(lists[idx], less, NULL).
+	list_radix_sort(lists[idx]);
+	list_index_invalidate(&listIndexes[idx]);
+}
+
+// (ex. list_sort_parallel list0 4 && etc.).
+void sortParallelL(char* name, int threadCnt) {
+	int idx = atoi(name + 4);
+
+	if (lists[idx] == NULL) {
+		return;
+	}
+
+	if (threadCnt < 0) {
+		return;
+	}
+
+	list_sort_parallel(lists[idx], less, NULL, (size_t)threadCnt);
+	list_index_invalidate(&listIndexes[idx]);
 }
 
 void swapL(const char* name, const int idx1, const int idx2) {
@@ -474,7 +577,7 @@ void swapL(const char* name, const int idx1, const int idx2) {
 		return;
 	}
 
-	int sizeOfList = list_size(lists[idx]);
+	int sizeOfList = list_index_size(&listIndexes[idx]);
 
 	// check idx1.
 	if (idx1 < 0 || idx1 >= sizeOfList) {
@@ -490,22 +593,7 @@ void swapL(const char* name, const int idx1, const int idx2) {
 		return;
 	}
 
-	struct list_elem* iter1;
-	struct list_elem* iter2;
-
-	// about idx1.
-	iter1 = list_begin(lists[idx]);
-	for (int cnt = 0; cnt < idx1; cnt++) {
-		iter1 = list_next(iter1);
-	}
-
-	// about idx2.
-	iter2 = list_begin(lists[idx]);
-	for (int cnt = 0; cnt < idx2; cnt++) {
-		iter2 = list_next(iter2);
-	}
-
-	list_swap(iter1, iter2);
+	list_index_swap(&listIndexes[idx], idx1, idx2);
 }
 
 // name1's list's duplicated element ==>> name2's list's Inserted.
@@ -517,7 +605,9 @@ void uniqueL(char* name1, char* name2) {
 		return;
 	}
 	
-	list_unique(lists[idx1], lists[idx2], less, NULL);
+	list_unique_eq(lists[idx1], lists[idx2], equal, NULL);
+	list_index_invalidate(&listIndexes[idx1]);
+	list_index_invalidate(&listIndexes[idx2]);
 }
 
 // (ex. list_reverse list0 ).
@@ -533,6 +623,7 @@ void reverseL(char* name) {
 	}
 
 	list_reverse(lists[idx]);
+	list_index_invalidate(&listIndexes[idx]);
 }
 
 // --- list end. ---.
@@ -825,6 +916,24 @@ _Bool lessH(const struct hash_elem* elem1, const struct hash_elem* elem2, void*
 	return elem1->value < elem2->value;
 }
 
+_Bool eqH(const struct hash_elem* elem1, const struct hash_elem* elem2, void* aux) {
+	return elem1->value == elem2->value;
+}
+
+// Keys are plain ints, so a lookup needs no hash_elem. (ex. hash_find_key(hashmaps[idx], &key, hash_int(key), keyEqH) ).
+_Bool keyEqH(const struct hash_elem* elem, const void* key, void* aux) {
+	return elem->value == *(const int*)key;
+}
+
+// aux is the table's slab (see createH()).
+struct hash_elem* makeH(const void* key, void* aux) {
+	struct hash_elem* newElem = slab_alloc(aux);
+	if (newElem != NULL) {
+		newElem->value = *(const int*)key; // In Proj. #1, We assume that key == value.
+	}
+	return newElem;
+}
+
 void printH(struct hash_elem* elem, void* aux) {
 	printf("%d ", elem->value);
 }
@@ -837,14 +946,35 @@ void tripleH(struct hash_elem* elem, void* aux) {
 	elem->value = elem->value * elem->value * elem->value;
 }
 
-void createH(char* name) {
+// squareH() and tripleH() for flat sets.
+int squareI(int key) {
+	return key * key;
+}
+
+int tripleI(int key) {
+	return key * key * key;
+}
+
+void createH(char* name, char* kind) {
 	const int idx = atoi(name + 4); // (ex. "hash0", and etc.).
 
 	if (idx < 0 || idx >= MAX_HASHMAP_CNT) {
 		return;
 	}
 
-	if (hashmaps[idx] != NULL) {
+	if (hashmaps[idx] != NULL || intSets[idx] != NULL) {
+		return;
+	}
+
+	/*
+	(ex. create hashtable hash0 ) makes a flat int set: every table here holds plain ints (key == value).
+	(ex. create hashtable hash0 chain ) and (ex. create hashtable hash0 open ) make a struct hash instead.
+	*/
+	if (strcmp(kind, "chain") != 0 && strcmp(kind, "open") != 0) {
+		intSets[idx] = malloc(sizeof(struct int_set) * 1);
+		if (intSets[idx] == NULL || !int_set_init(intSets[idx])) {
+			signal();
+		}
 		return;
 	}
 
@@ -853,7 +983,19 @@ void createH(char* name) {
 		signal();
 	}
 
-	hash_init(hashmaps[idx], hashFuncH, lessH, NULL);
+	// (ex. create hashtable hash0 open ) uses open addressing instead of chaining.
+	// aux is the slab makeH() allocates new elements from.
+	if (strcmp(kind, "open") == 0) {
+		if (!hash_init_open(hashmaps[idx], hashFuncH, lessH, &hashElemSlabs[idx])) {
+			signal();
+		}
+	}
+	else {
+		hash_init(hashmaps[idx], hashFuncH, lessH, &hashElemSlabs[idx]);
+	}
+	hash_set_eq(hashmaps[idx], eqH);
+	hash_set_stats(hashmaps[idx], true); // for hash_stats; testlib runs in one thread.
+	slab_init(&hashElemSlabs[idx], sizeof(struct hash_elem), SLAB_CHUNK_OBJS);
 
 	// Wait a minute...
 }
@@ -865,6 +1007,20 @@ void dumpdataH(char* name) {
 		return;
 	}
 
+	if (intSets[idx] != NULL) {
+		size_t pos = 0;
+		int key;
+
+		if (int_set_size(intSets[idx]) == 0) {
+			return;
+		}
+		while (int_set_next(intSets[idx], &pos, &key)) {
+			printf("%d ", key);
+		}
+		printf("\n");
+		return;
+	}
+
 	if (hashmaps[idx] == NULL) {
 		return;
 	}
@@ -886,14 +1042,67 @@ void insertH(char* name, int key) {
 		return;
 	}
 
+	if (intSets[idx] != NULL) {
+		if (!int_set_insert(intSets[idx], key)) {
+			signal();
+		}
+		return;
+	}
+
 	if (hashmaps[idx] == NULL) {
 		return;
 	}
 
-	struct hash_elem* newElem = malloc(sizeof(struct hash_elem) * 1);
-	newElem->value = key; // In Proj. #1, We assume that key == value.
+	// If key is already in the table, nothing is allocated or inserted.
+	if (hash_upsert(hashmaps[idx], &key, hash_int(key), keyEqH, makeH, NULL) == NULL) {
+		signal();
+	}
+}
+
+/*
+squareH() and tripleH() change keys, but a struct hash files each element by the hash of its key:
+the cached hash, the Bloom filter bits and the order of a tree-indexed bucket would all go stale.
+So hashmaps[idx] is rebuilt around FUNC, as int_set_apply() does:
+collect the elements, transform them, clear the table, and insert them again.
+Elements whose new keys are equal become one, and the rest go back to the slab.
+hash_apply() and hash_apply_parallel() only follow the links between elements, never keys, so they can do the transforming.
+*/
+void rebuildH(int idx, hash_action_func* func, int parallel, size_t threadCnt) {
+	const size_t cnt = hash_size(hashmaps[idx]);
+	struct hash_elem** elems = malloc(sizeof(struct hash_elem*) * (cnt + 1));
+	if (elems == NULL) {
+		signal();
+	}
+
+	// Step1. Collect.
+	struct hash_iterator iter;
+	size_t i = 0;
+	hash_first(&iter, hashmaps[idx]);
+	while (hash_next(&iter) != NULL) {
+		elems[i++] = hash_cur(&iter);
+	}
+
+	// Step2. Transform.
+	if (parallel) {
+		hash_apply_parallel(hashmaps[idx], threadCnt, func);
+	}
+	else {
+		hash_apply(hashmaps[idx], func);
+	}
+
+	// Step3. Clear, and Step4. insert again.
+	hash_clear(hashmaps[idx], NULL);
+	for (i = 0; i < cnt; i++) {
+		struct hash_elem* oldElem = hash_insert(hashmaps[idx], elems[i]);
+		if (oldElem == elems[i]) {
+			signal();
+		}
+		else if (oldElem != NULL) {
+			slab_free(&hashElemSlabs[idx], elems[i]);
+		}
+	}
 
-	hash_insert(hashmaps[idx], newElem);
+	free(elems);
 }
 
 void applyH(char* name, char* func_str) {
@@ -903,25 +1112,134 @@ void applyH(char* name, char* func_str) {
 		return;
 	}
 
+	// A flat set is rebuilt with the new keys, so equal results become one key.
+	if (intSets[idx] != NULL) {
+		if (strcmp(func_str, "square") == 0 && !int_set_apply(intSets[idx], squareI)) {
+			signal();
+		}
+		else if (strcmp(func_str, "triple") == 0 && !int_set_apply(intSets[idx], tripleI)) {
+			signal();
+		}
+		return;
+	}
+
 	if (hashmaps[idx] == NULL) {
 		return;
 	}
 
 	if (strcmp(func_str, "square") == 0) {
-		hash_apply(hashmaps[idx], squareH);
+		rebuildH(idx, squareH, 0, 0);
+	}
+	else if (strcmp(func_str, "triple") == 0) {
+		rebuildH(idx, tripleH, 0, 0);
+	}
+}
+
+// (ex. hash_apply_parallel hash0 square 4 ) is hash_apply on 4 threads. Without the thread count, one per CPU.
+void applyParallelH(char* name, char* func_str, int threadCnt) {
+	const int idx = atoi(name + 4);
+
+	if (idx < 0 || idx >= MAX_HASHMAP_CNT) {
+		return;
+	}
+
+	// A flat set is rebuilt on one thread.
+	if (intSets[idx] != NULL) {
+		applyH(name, func_str);
+		return;
+	}
+
+	if (hashmaps[idx] == NULL || threadCnt < 0) {
+		return;
+	}
+
+	if (strcmp(func_str, "square") == 0) {
+		rebuildH(idx, squareH, 1, (size_t)threadCnt);
 	}
 	else if (strcmp(func_str, "triple") == 0) {
-		hash_apply(hashmaps[idx], tripleH);
+		rebuildH(idx, tripleH, 1, (size_t)threadCnt);
+	}
+}
+
+// Partial result of hash_reduce, one per thread.
+struct reduceAcc {
+	long long sum;
+	int min;
+	int max;
+	size_t count;
+};
+
+void foldH(struct hash_elem* elem, void* acc, void* aux) {
+	struct reduceAcc* a = acc;
+
+	a->sum += elem->value;
+	if (elem->value < a->min) {
+		a->min = elem->value;
+	}
+	if (elem->value > a->max) {
+		a->max = elem->value;
+	}
+	a->count++;
+}
+
+void mergeH(void* dst, const void* src, void* aux) {
+	struct reduceAcc* d = dst;
+	const struct reduceAcc* s = src;
+
+	d->sum += s->sum;
+	if (s->min < d->min) {
+		d->min = s->min;
 	}
+	if (s->max > d->max) {
+		d->max = s->max;
+	}
+	d->count += s->count;
 }
 
-void freeH(struct hash_elem* elem, void* aux) {
-	if (elem == NULL) {
+// (ex. hash_reduce hash0 sum 4 ), and min, max, count. min and max of an empty table print nothing.
+void reduceH(char* name, char* op, int threadCnt) {
+	const int idx = atoi(name + 4);
+
+	if (idx < 0 || idx >= MAX_HASHMAP_CNT) {
+		return;
+	}
+
+	struct reduceAcc acc = { 0, INT_MAX, INT_MIN, 0 };
+
+	// A flat set is reduced on one thread.
+	if (intSets[idx] != NULL) {
+		size_t pos = 0;
+		int key;
+
+		while (int_set_next(intSets[idx], &pos, &key)) {
+			acc.sum += key;
+			acc.min = key < acc.min ? key : acc.min;
+			acc.max = key > acc.max ? key : acc.max;
+			acc.count++;
+		}
+	}
+	else if (hashmaps[idx] == NULL || threadCnt < 0) {
 		return;
 	}
+	else {
+		hash_reduce_parallel(hashmaps[idx], (size_t)threadCnt, foldH, mergeH, &acc, sizeof(acc));
+	}
 
-	free(elem);
-	// elem = NULL;
+	if (strcmp(op, "sum") == 0) {
+		printf("%lld\n", acc.sum);
+	}
+	else if (strcmp(op, "count") == 0) {
+		printf("%zu\n", acc.count);
+	}
+	else if (acc.count == 0) {
+		return;
+	}
+	else if (strcmp(op, "min") == 0) {
+		printf("%d\n", acc.min);
+	}
+	else if (strcmp(op, "max") == 0) {
+		printf("%d\n", acc.max);
+	}
 }
 
 void deleteH(char* name) {
@@ -931,11 +1249,23 @@ void deleteH(char* name) {
 		return;
 	}
 
+	if (intSets[idx] != NULL) {
+		int_set_destroy(intSets[idx]);
+		free(intSets[idx]);
+		intSets[idx] = NULL;
+		return;
+	}
+
 	if (hashmaps[idx] == NULL) {
 		return;
 	}
 
-	hash_destroy(hashmaps[idx], freeH);
+	// Elements are freed all at once with their slab, not one by one.
+	hash_destroy(hashmaps[idx], NULL);
+	slab_release(&hashElemSlabs[idx]);
+
+	free(hashmaps[idx]);
+	hashmaps[idx] = NULL;
 }
 
 void hashElemDeleteH(char* name, int key) {
@@ -945,17 +1275,17 @@ void hashElemDeleteH(char* name, int key) {
 		return;
 	}
 
-	if (hashmaps[idx] == NULL) {
+	if (intSets[idx] != NULL) {
+		int_set_delete(intSets[idx], key);
 		return;
 	}
 
-	struct hash_elem* targetElem = malloc(sizeof(struct hash_elem) * 1);
-	targetElem->value = key;
-	/* 
-	* Assume that key and value are same.
-	*/
+	if (hashmaps[idx] == NULL) {
+		return;
+	}
 
-	hash_delete(hashmaps[idx], targetElem);
+	struct hash_elem* deletedElem = hash_delete_key(hashmaps[idx], &key, hash_int(key), keyEqH);
+	slab_free(&hashElemSlabs[idx], deletedElem);
 }
 
 /* const */ bool emptyH(char* name) {
@@ -965,6 +1295,10 @@ void hashElemDeleteH(char* name, int key) {
 		return false; // ?...
 	}
 
+	if (intSets[idx] != NULL) {
+		return int_set_size(intSets[idx]) == 0;
+	}
+
 	if (hashmaps[idx] == NULL) {
 		return false; // ?...
 	}
@@ -982,6 +1316,10 @@ const size_t sizeH(char* name) {
 		return -1;
 	}
 
+	if (intSets[idx] != NULL) {
+		return int_set_size(intSets[idx]);
+	}
+
 	if (hashmaps[idx] == NULL) {
 		return -1;
 	}
@@ -989,97 +1327,856 @@ const size_t sizeH(char* name) {
 	return hash_size(hashmaps[idx]);
 }
 
-void clearH(char* name) {
+// (ex. hash_reserve hash0 100000 ) pre-sizes hash0 for a bulk load.
+void reserveH(char* name, size_t elemCnt) {
 	const int idx = atoi(name + 4);
 
 	if (idx < 0 || idx >= MAX_HASHMAP_CNT) {
 		return;
+	}
 
-		/*
-		return -1;
-		*/
+	if (intSets[idx] != NULL) {
+		if (!int_set_reserve(intSets[idx], elemCnt)) {
+			signal();
+		}
+		return;
 	}
 
 	if (hashmaps[idx] == NULL) {
 		return;
-
-		/*
-		return -1;
-		*/
 	}
 
-	hash_clear(hashmaps[idx], freeH);
+	if (!hash_reserve(hashmaps[idx], elemCnt)) {
+		signal();
+	}
 }
 
-const int findH(char* name, int key) {
+// (ex. hash_shrink_to_fit hash0 ).
+void shrinkToFitH(char* name) {
 	const int idx = atoi(name + 4);
 
 	if (idx < 0 || idx >= MAX_HASHMAP_CNT) {
-		/*
 		return;
-		*/
-
-		/*
-		return -1;
-		*/
+	}
 
-		exit(0); // ...
+	if (intSets[idx] != NULL) {
+		int_set_shrink_to_fit(intSets[idx]);
+		return;
 	}
 
 	if (hashmaps[idx] == NULL) {
-		/*
 		return;
-		*/
+	}
 
-		/*
-		return -1;
-		*/
+	hash_shrink_to_fit(hashmaps[idx]);
+}
 
-		exit(0); // ...
+// (ex. hash_save hash0 hash0.snap ) writes hash0's values to a binary snapshot file (see snapshot.h).
+void saveH(char* name, char* fileName) {
+	const int idx = atoi(name + 4);
+
+	if (idx < 0 || idx >= MAX_HASHMAP_CNT) {
+		return;
 	}
 
-	struct hash_elem* targetElem = malloc(sizeof(struct hash_elem) * 1);
-	targetElem->value = key;
+	if (intSets[idx] != NULL) {
+		if (!int_set_save(intSets[idx], fileName)) {
+			printf("cannot save %s\n", fileName);
+		}
+		return;
+	}
 
-	struct hash_elem* result = hash_find(hashmaps[idx], targetElem);
-	
-	// If findH() ERROR.
-	if (result == NULL) {
-		return HASH_FIND_ERROR;
+	if (hashmaps[idx] == NULL) {
+		return;
 	}
 
-	return result->value;
+	if (!hash_save(hashmaps[idx], fileName)) {
+		printf("cannot save %s\n", fileName);
+	}
 }
 
-void replaceH(char* name, int newKey) {
+// (ex. hash_load hash0 hash0.snap ) replaces hash0's contents with the snapshot's, sized up front, without replaying inserts.
+// Any kind of table can load a snapshot saved from any other.
+void loadH(char* name, char* fileName) {
 	const int idx = atoi(name + 4);
 
 	if (idx < 0 || idx >= MAX_HASHMAP_CNT) {
 		return;
+	}
 
-		/*
-		return -1;
-		*/
+	if (intSets[idx] != NULL) {
+		int_set_clear(intSets[idx]);
+		if (!int_set_load(intSets[idx], fileName)) {
+			printf("cannot load %s\n", fileName);
+		}
+		return;
 	}
 
 	if (hashmaps[idx] == NULL) {
 		return;
-
-		/*
-		return -1;
-		*/
 	}
 
-	struct hash_elem* newElem = malloc(sizeof(struct hash_elem) * 1);
-	newElem->value = newKey;
-
-	hash_replace(hashmaps[idx], newElem);
+	hash_clear(hashmaps[idx], NULL);
+	slab_release(&hashElemSlabs[idx]);
+	if (!hash_load(hashmaps[idx], fileName, makeH)) {
+		hash_clear(hashmaps[idx], NULL);
+		slab_release(&hashElemSlabs[idx]);
+		printf("cannot load %s\n", fileName);
+	}
 }
 
-// --- hashmap end. ---.
+// (ex. hash_bloom hash0 on ) puts a Bloom filter in front of hash0's chains, so most lookups of absent keys skip them.
+// (ex. hash_bloom hash0 off ) removes it. Only chained tables take one; open and flat tables already filter misses.
+void bloomH(char* name, char* onOff) {
+	const int idx = atoi(name + 4);
 
-int main(void) {
+	if (idx < 0 || idx >= MAX_HASHMAP_CNT) {
+		return;
+	}
+
+	if (hashmaps[idx] == NULL) {
+		return;
+	}
+
+	if (!hash_set_bloom(hashmaps[idx], strcmp(onOff, "off") != 0)) {
+		printf("cannot attach a bloom filter to %s\n", name);
+	}
+}
+
+// (ex. hash_stats hash0 ) prints load factor, counters, and a chain-length histogram.
+void statsH(char* name) {
+	const int idx = atoi(name + 4);
+
+	if (idx < 0 || idx >= MAX_HASHMAP_CNT) {
+		return;
+	}
+
+	// A flat set has no chains to report.
+	if (intSets[idx] != NULL) {
+		const size_t elemCnt = int_set_size(intSets[idx]);
+		const size_t slotCnt = int_set_capacity(intSets[idx]);
+
+		printf("elements %zu buckets %zu load %.2f\n", elemCnt, slotCnt, (double)elemCnt / slotCnt);
+		printf("flat int set, %zu bytes\n", slotCnt * sizeof(int));
+		return;
+	}
+
+	if (hashmaps[idx] == NULL) {
+		return;
+	}
+
+	struct hash_stats stats;
+	hash_stats(hashmaps[idx], &stats);
+
+	printf("elements %zu buckets %zu load %.2f\n", stats.elem_cnt, stats.bucket_cnt, stats.load_factor);
+	printf("rehashes %zu (%.3f ms)\n", stats.rehash_cnt, stats.rehash_ns / 1e6);
+	printf("searches %zu probes %zu (%.2f per search)\n", stats.lookup_cnt, stats.probe_cnt,
+		stats.lookup_cnt > 0 ? (double)stats.probe_cnt / stats.lookup_cnt : 0.0);
+	if (stats.bloom_bit_cnt > 0) {
+		const size_t passed = stats.bloom_fp_cnt + stats.bloom_neg_cnt;
+
+		printf("bloom %zu bits, misses filtered %zu false positives %zu (%.2f%%)\n", stats.bloom_bit_cnt,
+			stats.bloom_neg_cnt, stats.bloom_fp_cnt, passed > 0 ? 100.0 * stats.bloom_fp_cnt / passed : 0.0);
+	}
+	printf("chain max %zu mean %.2f\n", stats.max_chain, stats.mean_chain);
+	if (stats.tree_cnt > 0) {
+		printf("chains indexed by trees %zu\n", stats.tree_cnt);
+	}
+	for (int len = 0; len < HASH_STATS_HIST; len++) {
+		printf("chain %d%s: %zu\n", len, len == HASH_STATS_HIST - 1 ? "+" : "", stats.chain_hist[len]);
+	}
+}
+
+void clearH(char* name) {
+	const int idx = atoi(name + 4);
+
+	if (idx < 0 || idx >= MAX_HASHMAP_CNT) {
+		return;
+
+		/*
+		return -1;
+		*/
+	}
+
+	if (intSets[idx] != NULL) {
+		int_set_clear(intSets[idx]);
+		return;
+	}
+
+	if (hashmaps[idx] == NULL) {
+		return;
+
+		/*
+		return -1;
+		*/
+	}
+
+	hash_clear(hashmaps[idx], NULL);
+	slab_release(&hashElemSlabs[idx]);
+}
+
+const int findH(char* name, int key) {
+	const int idx = atoi(name + 4);
+
+	if (idx < 0 || idx >= MAX_HASHMAP_CNT) {
+		/*
+		return;
+		*/
+
+		/*
+		return -1;
+		*/
+
+		exit(0); // ...
+	}
+
+	if (intSets[idx] != NULL) {
+		return int_set_contains(intSets[idx], key) ? key : HASH_FIND_ERROR;
+	}
+
+	if (hashmaps[idx] == NULL) {
+		/*
+		return;
+		*/
+
+		/*
+		return -1;
+		*/
+
+		exit(0); // ...
+	}
+
+	struct hash_elem* result = hash_find_key(hashmaps[idx], &key, hash_int(key), keyEqH);
+	
+	// If findH() ERROR.
+	if (result == NULL) {
+		return HASH_FIND_ERROR;
+	}
+
+	return result->value;
+}
+
+// (ex. hash_find_batch hash0 10 100 ) looks up keys 10 ~ 109 at once, printing the ones found like hash_find.
+void findBatchH(char* name, int firstKey, int keyCnt) {
+	const int idx = atoi(name + 4);
+
+	if (idx < 0 || idx >= MAX_HASHMAP_CNT) {
+		return;
+	}
+
+	if (intSets[idx] != NULL) {
+		for (int i = 0; i < keyCnt; i++) {
+			if (int_set_contains(intSets[idx], firstKey + i)) {
+				printf("%d\n", firstKey + i);
+			}
+		}
+		return;
+	}
+
+	if (hashmaps[idx] == NULL || keyCnt <= 0) {
+		return;
+	}
+
+	struct hash_elem* keyElems = malloc(sizeof(struct hash_elem) * keyCnt);
+	struct hash_elem** keys = malloc(sizeof(struct hash_elem*) * keyCnt);
+	struct hash_elem** results = malloc(sizeof(struct hash_elem*) * keyCnt);
+	if (keyElems == NULL || keys == NULL || results == NULL) {
+		signal();
+	}
+
+	for (int i = 0; i < keyCnt; i++) {
+		keyElems[i].value = firstKey + i;
+		keys[i] = &keyElems[i];
+	}
+
+	hash_find_batch(hashmaps[idx], keys, keyCnt, results);
+	for (int i = 0; i < keyCnt; i++) {
+		if (results[i] != NULL) {
+			printf("%d\n", results[i]->value);
+		}
+	}
+
+	free(keyElems);
+	free(keys);
+	free(results);
+}
+
+void replaceH(char* name, int newKey) {
+	const int idx = atoi(name + 4);
+
+	if (idx < 0 || idx >= MAX_HASHMAP_CNT) {
+		return;
+
+		/*
+		return -1;
+		*/
+	}
+
+	// key == value, so a replace is an insert.
+	if (intSets[idx] != NULL) {
+		if (!int_set_insert(intSets[idx], newKey)) {
+			signal();
+		}
+		return;
+	}
+
+	if (hashmaps[idx] == NULL) {
+		return;
+
+		/*
+		return -1;
+		*/
+	}
+
+	// key == value, so replacing an element with an equal one changes nothing: an upsert is enough.
+	if (hash_upsert(hashmaps[idx], &newKey, hash_int(newKey), keyEqH, makeH, NULL) == NULL) {
+		signal();
+	}
+}
+
+// --- hashmap end. ---.
+
+// --- btree start. ---.
+
+_Bool lessT(const struct btree_elem* elem1, const struct btree_elem* elem2, void* aux) {
+	return btree_entry(elem1, struct btreeEntry, elem)->value < btree_entry(elem2, struct btreeEntry, elem)->value;
+}
+
+void printT(struct btree_elem* elem, void* aux) {
+	printf("%d ", btree_entry(elem, struct btreeEntry, elem)->value);
+}
+
+// (ex. create btree btree0 ).
+void createT(char* name) {
+	const int idx = atoi(name + 5); // (ex. "btree0", and etc.).
+
+	if (idx < 0 || idx >= MAX_BTREE_CNT) {
+		return;
+	}
+
+	if (btrees[idx] != NULL) {
+		return;
+	}
+
+	btrees[idx] = malloc(sizeof(struct btree) * 1);
+	if (btrees[idx] == NULL) {
+		signal();
+	}
+
+	btree_init(btrees[idx], lessT, NULL);
+	slab_init(&btreeEntrySlabs[idx], sizeof(struct btreeEntry), SLAB_CHUNK_OBJS);
+}
+
+// Prints the elements in ascending order.
+void dumpdataT(char* name) {
+	const int idx = atoi(name + 5);
+
+	if (idx < 0 || idx >= MAX_BTREE_CNT) {
+		return;
+	}
+
+	if (btrees[idx] == NULL) {
+		return;
+	}
+
+	if (btree_empty(btrees[idx])) {
+		return;
+	}
+
+	btree_apply(btrees[idx], printT);
+	printf("\n");
+}
+
+void deleteT(char* name) {
+	const int idx = atoi(name + 5);
+
+	if (idx < 0 || idx >= MAX_BTREE_CNT) {
+		return;
+	}
+
+	if (btrees[idx] == NULL) {
+		return;
+	}
+
+	btree_destroy(btrees[idx], NULL);
+	slab_release(&btreeEntrySlabs[idx]);
+
+	free(btrees[idx]);
+	btrees[idx] = NULL;
+}
+
+// (ex. btree_insert btree0 5 ).
+void insertT(char* name, int key) {
+	const int idx = atoi(name + 5);
+
+	if (idx < 0 || idx >= MAX_BTREE_CNT) {
+		return;
+	}
+
+	if (btrees[idx] == NULL) {
+		return;
+	}
+
+	struct btreeEntry* newEntry = slab_alloc(&btreeEntrySlabs[idx]);
+	if (newEntry == NULL) {
+		signal();
+	}
+	newEntry->value = key;
+
+	// btree_insert() returns the new element itself when it runs out of memory.
+	struct btree_elem* oldElem = btree_insert(btrees[idx], &newEntry->elem);
+	if (oldElem == &newEntry->elem) {
+		signal();
+	}
+	// If key is already in the tree, newEntry is not inserted.
+	if (oldElem != NULL) {
+		slab_free(&btreeEntrySlabs[idx], newEntry);
+	}
+}
+
+// (ex. btree_delete btree0 5 ).
+void btreeElemDeleteT(char* name, int key) {
+	const int idx = atoi(name + 5);
+
+	if (idx < 0 || idx >= MAX_BTREE_CNT) {
+		return;
+	}
+
+	if (btrees[idx] == NULL) {
+		return;
+	}
+
+	struct btreeEntry target;
+	target.value = key;
+
+	struct btree_elem* deletedElem = btree_delete(btrees[idx], &target.elem);
+	if (deletedElem != NULL) {
+		slab_free(&btreeEntrySlabs[idx], btree_entry(deletedElem, struct btreeEntry, elem));
+	}
+}
+
+const size_t sizeT(char* name) {
+	const int idx = atoi(name + 5);
+
+	if (idx < 0 || idx >= MAX_BTREE_CNT) {
+		return -1;
+	}
+
+	if (btrees[idx] == NULL) {
+		return -1;
+	}
+
+	return btree_size(btrees[idx]);
+}
+
+/*
+(ex. btree_find btree0 5 ), (ex. btree_lower_bound btree0 5 ), (ex. btree_upper_bound btree0 5 ).
+Prints the element found, or nothing.
+*/
+void findT(char* name, char* how, int key) {
+	const int idx = atoi(name + 5);
+
+	if (idx < 0 || idx >= MAX_BTREE_CNT) {
+		return;
+	}
+
+	if (btrees[idx] == NULL) {
+		return;
+	}
+
+	struct btreeEntry target;
+	target.value = key;
+
+	struct btree_iterator it;
+	struct btree_elem* result;
+	if (strcmp(how, "lower_bound") == 0) {
+		result = btree_lower_bound(&it, btrees[idx], &target.elem);
+	}
+	else if (strcmp(how, "upper_bound") == 0) {
+		result = btree_upper_bound(&it, btrees[idx], &target.elem);
+	}
+	else {
+		result = btree_find(btrees[idx], &target.elem);
+	}
+
+	if (result != NULL) {
+		printf("%d\n", btree_entry(result, struct btreeEntry, elem)->value);
+	}
+}
+
+// (ex. btree_range btree0 10 20 ) prints the elements e with 10 <= e < 20 in ascending order.
+void rangeT(char* name, int lo, int hi) {
+	const int idx = atoi(name + 5);
+
+	if (idx < 0 || idx >= MAX_BTREE_CNT) {
+		return;
+	}
+
+	if (btrees[idx] == NULL) {
+		return;
+	}
+
+	struct btreeEntry loEntry;
+	loEntry.value = lo;
+
+	// One descent finds the first element; the iterator walks the leaves from there.
+	struct btree_iterator it;
+	struct btree_elem* e = btree_lower_bound(&it, btrees[idx], &loEntry.elem);
+	if (e == NULL || btree_entry(e, struct btreeEntry, elem)->value >= hi) {
+		return;
+	}
+
+	for (; e != NULL && btree_entry(e, struct btreeEntry, elem)->value < hi; e = btree_next(&it)) {
+		printT(e, NULL);
+	}
+	printf("\n");
+}
+
+// --- btree end. ---.
+
+// --- cache start. ---.
+
+unsigned int hashFuncC(const struct cache_elem* elem, void* aux) {
+	return hash_int(cache_entry(elem, struct cacheEntry, elem)->key);
+}
+
+_Bool lessC(const struct cache_elem* elem1, const struct cache_elem* elem2, void* aux) {
+	return cache_entry(elem1, struct cacheEntry, elem)->key < cache_entry(elem2, struct cacheEntry, elem)->key;
+}
+
+void printC(struct cache_elem* elem, void* aux) {
+	const struct cacheEntry* entry = cache_entry(elem, struct cacheEntry, elem);
+	printf("%d:%d ", entry->key, entry->value);
+}
+
+// (ex. create cache cache0 100 ), (ex. create cache cache0 100 clock ).
+void createC(char* name, int capacity, char* policy) {
+	const int idx = atoi(name + 5); // (ex. "cache0", and etc.).
+
+	if (idx < 0 || idx >= MAX_CACHE_CNT || capacity <= 0) {
+		return;
+	}
+
+	if (caches[idx] != NULL) {
+		return;
+	}
+
+	caches[idx] = malloc(sizeof(struct cache) * 1);
+	if (caches[idx] == NULL) {
+		signal();
+	}
+
+	const enum cache_policy cachePolicy = strcmp(policy, "clock") == 0 ? CACHE_CLOCK : CACHE_LRU;
+	if (!cache_init(caches[idx], (size_t)capacity, cachePolicy, hashFuncC, lessC, NULL)) {
+		signal();
+	}
+	slab_init(&cacheEntrySlabs[idx], sizeof(struct cacheEntry), SLAB_CHUNK_OBJS);
+}
+
+// Prints key:value pairs, the next to be evicted last.
+void dumpdataC(char* name) {
+	const int idx = atoi(name + 5);
+
+	if (idx < 0 || idx >= MAX_CACHE_CNT) {
+		return;
+	}
+
+	if (caches[idx] == NULL) {
+		return;
+	}
+
+	if (cache_size(caches[idx]) == 0) {
+		return;
+	}
+
+	cache_apply(caches[idx], printC);
+	printf("\n");
+}
+
+void deleteC(char* name) {
+	const int idx = atoi(name + 5);
+
+	if (idx < 0 || idx >= MAX_CACHE_CNT) {
+		return;
+	}
+
+	if (caches[idx] == NULL) {
+		return;
+	}
+
+	// The entries go back to the slab all at once.
+	cache_destroy(caches[idx], NULL);
+	slab_release(&cacheEntrySlabs[idx]);
+
+	free(caches[idx]);
+	caches[idx] = NULL;
+}
+
+// (ex. cache_put cache0 3 30 ) maps 3 to 30, evicting an entry if cache0 is full.
+void putC(char* name, int key, int value) {
+	const int idx = atoi(name + 5);
+
+	if (idx < 0 || idx >= MAX_CACHE_CNT) {
+		return;
+	}
+
+	if (caches[idx] == NULL) {
+		return;
+	}
+
+	struct cacheEntry* newEntry = slab_alloc(&cacheEntrySlabs[idx]);
+	if (newEntry == NULL) {
+		signal();
+	}
+	newEntry->key = key;
+	newEntry->value = value;
+
+	// The old entry for key, or the evicted one.
+	struct cache_elem* displaced = cache_put(caches[idx], &newEntry->elem);
+	if (displaced != NULL) {
+		slab_free(&cacheEntrySlabs[idx], cache_entry(displaced, struct cacheEntry, elem));
+	}
+}
+
+// (ex. cache_get cache0 3 ) prints the value of 3, or "miss".
+void getC(char* name, int key) {
+	const int idx = atoi(name + 5);
+
+	if (idx < 0 || idx >= MAX_CACHE_CNT) {
+		return;
+	}
+
+	if (caches[idx] == NULL) {
+		return;
+	}
+
+	struct cacheEntry target;
+	target.key = key;
+
+	struct cache_elem* found = cache_get(caches[idx], &target.elem);
+	if (found == NULL) {
+		printf("miss\n");
+		return;
+	}
+
+	printf("%d\n", cache_entry(found, struct cacheEntry, elem)->value);
+}
+
+// (ex. cache_delete cache0 3 ).
+void cacheElemDeleteC(char* name, int key) {
+	const int idx = atoi(name + 5);
+
+	if (idx < 0 || idx >= MAX_CACHE_CNT) {
+		return;
+	}
+
+	if (caches[idx] == NULL) {
+		return;
+	}
+
+	struct cacheEntry target;
+	target.key = key;
+
+	struct cache_elem* deleted = cache_delete(caches[idx], &target.elem);
+	if (deleted != NULL) {
+		slab_free(&cacheEntrySlabs[idx], cache_entry(deleted, struct cacheEntry, elem));
+	}
+}
+
+const size_t sizeC(char* name) {
+	const int idx = atoi(name + 5);
+
+	if (idx < 0 || idx >= MAX_CACHE_CNT) {
+		return -1;
+	}
+
+	if (caches[idx] == NULL) {
+		return -1;
+	}
+
+	return cache_size(caches[idx]);
+}
+
+// (ex. cache_stats cache0 ).
+void statsC(char* name) {
+	const int idx = atoi(name + 5);
+
+	if (idx < 0 || idx >= MAX_CACHE_CNT) {
+		return;
+	}
+
+	if (caches[idx] == NULL) {
+		return;
+	}
+
+	const struct cache* c = caches[idx];
+	const size_t lookups = c->hit_cnt + c->miss_cnt;
+
+	printf("entries %zu capacity %zu policy %s\n", cache_size(caches[idx]), cache_capacity(caches[idx]),
+		c->policy == CACHE_CLOCK ? "clock" : "lru");
+	printf("hits %zu misses %zu (%.2f%% hit rate) evictions %zu\n", c->hit_cnt, c->miss_cnt,
+		lookups > 0 ? 100.0 * c->hit_cnt / lookups : 0.0, c->evict_cnt);
+}
+
+// --- cache end. ---.
+
+// --- chash start. ---.
+// chashN holds the same hash_elem's as hashN, with the same hashFuncH(), lessH() and eqH().
+
+// (ex. create chash chash0 ), (ex. create chash chash0 8 ) with 8 segments. Without the segment count, 4 per CPU.
+void createCH(char* name, int segCnt) {
+	const int idx = atoi(name + 5); // (ex. "chash0", and etc.).
+
+	if (idx < 0 || idx >= MAX_CHASH_CNT || segCnt < 0) {
+		return;
+	}
+
+	if (chashes[idx] != NULL) {
+		return;
+	}
+
+	chashes[idx] = malloc(sizeof(struct chash) * 1);
+	if (chashes[idx] == NULL) {
+		signal();
+	}
+
+	if (!chash_init(chashes[idx], (size_t)segCnt, hashFuncH, lessH, NULL)) {
+		signal();
+	}
+	chash_set_eq(chashes[idx], eqH);
+	slab_init(&chashElemSlabs[idx], sizeof(struct hash_elem), SLAB_CHUNK_OBJS);
+}
+
+void dumpdataCH(char* name) {
+	const int idx = atoi(name + 5);
+
+	if (idx < 0 || idx >= MAX_CHASH_CNT) {
+		return;
+	}
+
+	if (chashes[idx] == NULL) {
+		return;
+	}
+
+	if (chash_size(chashes[idx]) == 0) {
+		return;
+	}
+
+	chash_apply(chashes[idx], printH);
+	printf("\n");
+}
+
+void deleteCH(char* name) {
+	const int idx = atoi(name + 5);
+
+	if (idx < 0 || idx >= MAX_CHASH_CNT) {
+		return;
+	}
+
+	if (chashes[idx] == NULL) {
+		return;
+	}
+
+	// Elements are freed all at once with their slab, not one by one.
+	chash_destroy(chashes[idx], NULL);
+	slab_release(&chashElemSlabs[idx]);
+
+	free(chashes[idx]);
+	chashes[idx] = NULL;
+}
+
+/*
+if option == 0, then chash_insert() Call.
+if option == 1, then chash_replace() Call.
+*/
+void insertCH(char* name, int key, int option) {
+	const int idx = atoi(name + 5);
+
+	if (idx < 0 || idx >= MAX_CHASH_CNT) {
+		return;
+	}
+
+	if (chashes[idx] == NULL) {
+		return;
+	}
+
+	struct hash_elem* newElem = slab_alloc(&chashElemSlabs[idx]);
+	if (newElem == NULL) {
+		signal();
+	}
+	newElem->value = key; // key == value, as in hashN.
+
+	// The element that stayed out of the table: newElem itself for a duplicate insert, the old one for a replace.
+	struct hash_elem* oldElem = option == 0 ? chash_insert(chashes[idx], newElem) : chash_replace(chashes[idx], newElem);
+	if (oldElem != NULL) {
+		slab_free(&chashElemSlabs[idx], option == 0 ? newElem : oldElem);
+	}
+}
+
+// (ex. chash_delete chash0 3 ).
+void chashElemDeleteCH(char* name, int key) {
+	const int idx = atoi(name + 5);
+
+	if (idx < 0 || idx >= MAX_CHASH_CNT) {
+		return;
+	}
+
+	if (chashes[idx] == NULL) {
+		return;
+	}
+
+	struct hash_elem target;
+	target.value = key;
+
+	struct hash_elem* deleted = chash_delete(chashes[idx], &target);
+	if (deleted != NULL) {
+		slab_free(&chashElemSlabs[idx], deleted);
+	}
+}
+
+// (ex. chash_find chash0 3 ) prints 3 if chash0 holds it, like hash_find.
+const int findCH(char* name, int key) {
+	const int idx = atoi(name + 5);
+
+	if (idx < 0 || idx >= MAX_CHASH_CNT) {
+		return HASH_FIND_ERROR;
+	}
+
+	if (chashes[idx] == NULL) {
+		return HASH_FIND_ERROR;
+	}
+
+	struct hash_elem target;
+	target.value = key;
+
+	struct hash_elem* result = chash_find(chashes[idx], &target);
+	if (result == NULL) {
+		return HASH_FIND_ERROR;
+	}
+
+	return result->value;
+}
+
+const size_t sizeCH(char* name) {
+	const int idx = atoi(name + 5);
+
+	if (idx < 0 || idx >= MAX_CHASH_CNT) {
+		return -1;
+	}
+
+	if (chashes[idx] == NULL) {
+		return -1;
+	}
+
+	return chash_size(chashes[idx]);
+}
+
+// --- chash end. ---.
+
+int main(void) {
 	srand(time(NULL)); // for randomization.
+	random_init((uint64_t)time(NULL)); // list_shuffle()'s generator. (ex. list_shuffle_seed 1234 ) replays a run.
+	slab_init(&listItemSlab, sizeof(struct list_item), SLAB_CHUNK_OBJS);
 	// list_shuffle() func() ȣ  ªٸ,  seedNumber ڷ   ϴ. , Random   ϴ.
 	// list_shuffle() func(), srand(time(NULL)); Remove...
 
@@ -1098,12 +2195,21 @@ int main(void) {
 				createB(words[2], (size_t)atoi(words[3]));
 			}
 			else if (strcmp(words[1], "hashtable") == 0) {
-				createH(words[2]);
+				createH(words[2], words[3]);
+			}
+			else if (strcmp(words[1], "btree") == 0) {
+				createT(words[2]);
+			}
+			else if (strcmp(words[1], "cache") == 0) {
+				createC(words[2], atoi(words[3]), words[4]);
+			}
+			else if (strcmp(words[1], "chash") == 0) {
+				createCH(words[2], atoi(words[3]));
 			}
 		}
 		// (ex. dumpdata list0 ).
 		else if (strcmp(words[0], "dumpdata") == 0) {
-			char type[4 + 1];
+			char type[sizeof(words[1])]; // (ex. "btree0" -> "btree").
 			strncpy(type, words[1], strlen(words[1]) - 1);
 			type[strlen(words[1]) - 1] = '\0';
 
@@ -1117,10 +2223,19 @@ int main(void) {
 			else if (strcmp(type, "hash") == 0) {
 				dumpdataH(words[1]);
 			}
+			else if (strcmp(type, "btree") == 0) {
+				dumpdataT(words[1]);
+			}
+			else if (strcmp(type, "cache") == 0) {
+				dumpdataC(words[1]);
+			}
+			else if (strcmp(type, "chash") == 0) {
+				dumpdataCH(words[1]);
+			}
 		}
 		// (ex. delete list0 ).
 		else if (strcmp(words[0], "delete") == 0) {
-			char type[4 + 1];
+			char type[sizeof(words[1])]; // (ex. "btree0" -> "btree").
 			strncpy(type, words[1], strlen(words[1]) - 1);
 			type[strlen(words[1]) - 1] = '\0';
 
@@ -1133,6 +2248,15 @@ int main(void) {
 			else if (strcmp(type, "hash") == 0) {
 				deleteH(words[1]);
 			}
+			else if (strcmp(type, "btree") == 0) {
+				deleteT(words[1]);
+			}
+			else if (strcmp(type, "cache") == 0) {
+				deleteC(words[1]);
+			}
+			else if (strcmp(type, "chash") == 0) {
+				deleteCH(words[1]);
+			}
 		}
 		// (ex. list_splice list0 2 list1 1 4 ).
 		else if ((strcmp(words[0], "list_splice") == 0)) {
@@ -1201,9 +2325,17 @@ int main(void) {
 		else if (strcmp(words[0], "list_shuffle") == 0) {
 			shuffleL(words[1]);
 		}
+		// (ex. list_shuffle_seed 1234 ).
+		else if (strcmp(words[0], "list_shuffle_seed") == 0) {
+			shuffleSeedL(words[1]);
+		}
 		else if (strcmp(words[0], "list_sort") == 0) {
 			sortL(words[1]);
 		}
+		// (ex. list_sort_parallel list0 4 ). 0 threads means one per CPU.
+		else if (strcmp(words[0], "list_sort_parallel") == 0) {
+			sortParallelL(words[1], atoi(words[2]));
+		}
 		else if (strcmp(words[0], "list_swap") == 0) {
 			swapL(words[1], atoi(words[2]), atoi(words[3]));
 		}
@@ -1311,6 +2443,12 @@ int main(void) {
 		else if (strcmp(words[0], "hash_apply") == 0) {
 				applyH(words[1], words[2]);
 		}
+		else if (strcmp(words[0], "hash_apply_parallel") == 0) {
+			applyParallelH(words[1], words[2], atoi(words[3]));
+		}
+		else if (strcmp(words[0], "hash_reduce") == 0) {
+			reduceH(words[1], words[2], atoi(words[3]));
+		}
 		else if (strcmp(words[0], "hash_delete") == 0) {
 			hashElemDeleteH(words[1], atoi(words[2]));
 		}
@@ -1336,6 +2474,27 @@ int main(void) {
 		else if (strcmp(words[0], "hash_clear") == 0) {
 			clearH(words[1]);
 		}
+		else if (strcmp(words[0], "hash_reserve") == 0) {
+			reserveH(words[1], (size_t)strtoull(words[2], NULL, 10));
+		}
+		else if (strcmp(words[0], "hash_shrink_to_fit") == 0) {
+			shrinkToFitH(words[1]);
+		}
+		else if (strcmp(words[0], "hash_stats") == 0) {
+			statsH(words[1]);
+		}
+		else if (strcmp(words[0], "hash_bloom") == 0) {
+			bloomH(words[1], words[2]);
+		}
+		else if (strcmp(words[0], "hash_save") == 0) {
+			saveH(words[1], words[2]);
+		}
+		else if (strcmp(words[0], "hash_load") == 0) {
+			loadH(words[1], words[2]);
+		}
+		else if (strcmp(words[0], "hash_find_batch") == 0) {
+			findBatchH(words[1], atoi(words[2]), atoi(words[3]));
+		}
 		else if (strcmp(words[0], "hash_find") == 0) {
 			const int temp = findH(words[1], atoi(words[2]));
 
@@ -1345,6 +2504,72 @@ int main(void) {
 
 			printf("%d\n", temp);
 		}
+		else if (strcmp(words[0], "btree_insert") == 0) {
+			insertT(words[1], atoi(words[2]));
+		}
+		else if (strcmp(words[0], "btree_delete") == 0) {
+			btreeElemDeleteT(words[1], atoi(words[2]));
+		}
+		else if (strcmp(words[0], "btree_size") == 0) {
+			const size_t temp = sizeT(words[1]);
+			if (temp == -1) {
+				continue;
+			}
+
+			printf("%zu\n", temp);
+		}
+		else if (strcmp(words[0], "btree_find") == 0 || strcmp(words[0], "btree_lower_bound") == 0 || strcmp(words[0], "btree_upper_bound") == 0) {
+			findT(words[1], words[0] + 6, atoi(words[2]));
+		}
+		else if (strcmp(words[0], "btree_range") == 0) {
+			rangeT(words[1], atoi(words[2]), atoi(words[3]));
+		}
+		else if (strcmp(words[0], "cache_put") == 0) {
+			putC(words[1], atoi(words[2]), atoi(words[3]));
+		}
+		else if (strcmp(words[0], "cache_get") == 0) {
+			getC(words[1], atoi(words[2]));
+		}
+		else if (strcmp(words[0], "cache_delete") == 0) {
+			cacheElemDeleteC(words[1], atoi(words[2]));
+		}
+		else if (strcmp(words[0], "cache_size") == 0) {
+			const size_t temp = sizeC(words[1]);
+			if (temp == -1) {
+				continue;
+			}
+
+			printf("%zu\n", temp);
+		}
+		else if (strcmp(words[0], "cache_stats") == 0) {
+			statsC(words[1]);
+		}
+		else if (strcmp(words[0], "chash_insert") == 0) {
+			insertCH(words[1], atoi(words[2]), 0);
+		}
+		else if (strcmp(words[0], "chash_replace") == 0) {
+			insertCH(words[1], atoi(words[2]), 1);
+		}
+		else if (strcmp(words[0], "chash_delete") == 0) {
+			chashElemDeleteCH(words[1], atoi(words[2]));
+		}
+		else if (strcmp(words[0], "chash_find") == 0) {
+			const int temp = findCH(words[1], atoi(words[2]));
+
+			if (temp == HASH_FIND_ERROR) {
+				continue;
+			}
+
+			printf("%d\n", temp);
+		}
+		else if (strcmp(words[0], "chash_size") == 0) {
+			const size_t temp = sizeCH(words[1]);
+			if (temp == -1) {
+				continue;
+			}
+
+			printf("%zu\n", temp);
+		}
 		else if (strcmp(words[0], "hash_replace") == 0) {
 			replaceH(words[1], atoi(words[2]));
 			// replaceH() : , ׳ Addϴ func().
@@ -0,0 +1,97 @@
+/* Pseudo-random number generator.
+
+See random.h for basic information. */
+
+#include "random.h"
+#include <assert.h>
+#include <stdbool.h>
+
+#define ASSERT(CONDITION) assert(CONDITION)
+
+/* Generator state.  Must not be all zeros. */
+static uint64_t state[4];
+
+/* Has random_init() been called? */
+static bool inited;
+
+/* Returns X rotated left by K bits. */
+static inline uint64_t
+rotl (uint64_t x, int k)
+{
+  return (x << k) | (x >> (64 - k));
+}
+
+/* Advances splitmix64 state *X and returns its next output.
+   Used only to spread a seed over the four state words. */
+static uint64_t
+splitmix64 (uint64_t *x)
+{
+  uint64_t z = (*x += 0x9e3779b97f4a7c15u);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9u;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebu;
+  return z ^ (z >> 31);
+}
+
+/* Initializes or reinitializes the generator with SEED.  Any
+   seed, including 0, is fine.  Afterward the generator produces
+   the same sequence as it did the last time it got SEED. */
+void
+random_init (uint64_t seed)
+{
+  int i;
+
+  for (i = 0; i < 4; i++)
+    state[i] = splitmix64 (&seed);
+  inited = true;
+}
+
+/* Returns a pseudo-random 64-bit number.  If random_init() was
+   never called, the generator starts from seed 0. */
+uint64_t
+random_u64 (void)
+{
+  uint64_t result, t;
+
+  if (!inited)
+    random_init (0);
+
+  result = rotl (state[1] * 5, 7) * 9;
+  t = state[1] << 17;
+  state[2] ^= state[0];
+  state[3] ^= state[1];
+  state[1] ^= state[2];
+  state[0] ^= state[3];
+  state[2] ^= t;
+  state[3] = rotl (state[3], 45);
+  return result;
+}
+
+/* Returns a pseudo-random number uniformly distributed in
+   [0, BOUND), which must be nonzero.
+
+   Uses Lemire's multiply-shift method: the high half of the
+   128-bit product of a random word and BOUND is the result, and
+   the rare products whose low half falls in the first
+   2**64 % BOUND values are rejected, so unlike `random % BOUND'
+   no value is more likely than another. */
+uint64_t
+random_bounded (uint64_t bound)
+{
+  unsigned __int128 m;
+  uint64_t low;
+
+  ASSERT (bound != 0);
+
+  m = (unsigned __int128) random_u64 () * bound;
+  low = (uint64_t) m;
+  if (low < bound)
+    {
+      uint64_t threshold = -bound % bound;
+      while (low < threshold)
+        {
+          m = (unsigned __int128) random_u64 () * bound;
+          low = (uint64_t) m;
+        }
+    }
+  return (uint64_t) (m >> 64);
+}
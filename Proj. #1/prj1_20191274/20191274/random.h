@@ -0,0 +1,19 @@
+#ifndef __MYLIB_RANDOM_H
+#define __MYLIB_RANDOM_H
+
+/* Pseudo-random number generator.
+
+   xoshiro256** (Blackman and Vigna), seeded through splitmix64.
+   It is fast, passes the usual statistical test batteries, and
+   produces the same sequence every time it is given the same
+   seed, so runs that depend on it can be replayed.  It is not
+   suitable for cryptographic use. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+void random_init (uint64_t seed);
+uint64_t random_u64 (void);
+uint64_t random_bounded (uint64_t bound);
+
+#endif /* random.h */
@@ -0,0 +1,132 @@
+/* Slab allocator for fixed-size objects.
+
+See slab.h for basic information. */
+
+#include "slab.h"
+#include <assert.h>
+#include <stdlib.h>
+#include "round.h"
+
+#define ASSERT(CONDITION) assert(CONDITION)
+
+/* Header at the start of every chunk.  The objects follow it. */
+struct slab_chunk
+  {
+    struct slab_chunk *next;    /* Next older chunk. */
+  };
+
+/* A freed object, reused as a free list link. */
+struct slab_free
+  {
+    struct slab_free *next;     /* Next freed object. */
+  };
+
+/* Objects are aligned to, and at least as big as, a pointer.
+   That suits the list and hash nodes this is written for, and
+   leaves room for the free list link. */
+#define SLAB_ALIGN (sizeof (void *))
+
+/* Initializes SLAB to hand out objects of OBJ_SIZE bytes, taking
+   memory from malloc() OBJS_PER_CHUNK objects at a time.  No
+   memory is allocated until the first slab_alloc(). */
+void
+slab_init (struct slab *slab, size_t obj_size, size_t objs_per_chunk)
+{
+  ASSERT (slab != NULL);
+  ASSERT (obj_size > 0);
+  ASSERT (objs_per_chunk > 0);
+
+  if (obj_size < sizeof (struct slab_free))
+    obj_size = sizeof (struct slab_free);
+  slab->obj_size = ROUND_UP (obj_size, SLAB_ALIGN);
+  slab->objs_per_chunk = objs_per_chunk;
+  slab->chunks = NULL;
+  slab->free_list = NULL;
+  slab->next = slab->limit = NULL;
+  slab->used = 0;
+}
+
+/* Returns an uninitialized object from SLAB, or a null pointer
+   if memory is exhausted.  Recently freed objects are reused
+   first; otherwise objects are carved out of the newest chunk in
+   address order. */
+void *
+slab_alloc (struct slab *slab)
+{
+  void *obj;
+
+  ASSERT (slab != NULL);
+
+  if (slab->free_list != NULL)
+    {
+      obj = slab->free_list;
+      slab->free_list = slab->free_list->next;
+    }
+  else
+    {
+      if (slab->next == slab->limit)
+        {
+          size_t chunk_size = ROUND_UP (sizeof (struct slab_chunk), SLAB_ALIGN)
+                              + slab->obj_size * slab->objs_per_chunk;
+          struct slab_chunk *chunk = malloc (chunk_size);
+          if (chunk == NULL)
+            return NULL;
+
+          chunk->next = slab->chunks;
+          slab->chunks = chunk;
+          slab->next = (char *) chunk
+                       + ROUND_UP (sizeof (struct slab_chunk), SLAB_ALIGN);
+          slab->limit = (char *) chunk + chunk_size;
+        }
+      obj = slab->next;
+      slab->next += slab->obj_size;
+    }
+
+  slab->used++;
+  return obj;
+}
+
+/* Returns OBJ, which must have come from slab_alloc() on SLAB,
+   to SLAB.  Does nothing if OBJ is a null pointer. */
+void
+slab_free (struct slab *slab, void *obj)
+{
+  struct slab_free *f = obj;
+
+  ASSERT (slab != NULL);
+
+  if (f == NULL)
+    return;
+
+  ASSERT (slab->used > 0);
+  f->next = slab->free_list;
+  slab->free_list = f;
+  slab->used--;
+}
+
+/* Frees every chunk of SLAB at once, invalidating all objects
+   allocated from it.  SLAB remains initialized and can be used
+   again. */
+void
+slab_release (struct slab *slab)
+{
+  ASSERT (slab != NULL);
+
+  while (slab->chunks != NULL)
+    {
+      struct slab_chunk *next = slab->chunks->next;
+      free (slab->chunks);
+      slab->chunks = next;
+    }
+  slab->free_list = NULL;
+  slab->next = slab->limit = NULL;
+  slab->used = 0;
+}
+
+/* Returns the number of objects allocated from SLAB and not yet
+   freed. */
+size_t
+slab_used (const struct slab *slab)
+{
+  return slab->used;
+}
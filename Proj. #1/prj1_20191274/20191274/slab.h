@@ -0,0 +1,52 @@
+#ifndef __MYLIB_SLAB_H
+#define __MYLIB_SLAB_H
+
+/* Slab allocator for fixed-size objects.
+
+   A slab hands out objects of one size, carved out of large
+   chunks obtained from malloc().  Freed objects go on a free
+   list and are handed out again before any new chunk is carved,
+   so a container whose size stays roughly constant stops calling
+   malloc() altogether, and objects allocated one after another
+   sit next to each other in memory.
+
+   Objects can be returned one at a time with slab_free(), or all
+   at once with slab_release(), which gives every chunk back to
+   malloc() in O(chunks) time.  Typical use, one slab per
+   container:
+
+      struct slab item_slab;
+
+      slab_init (&item_slab, sizeof (struct list_item), 1024);
+      item = slab_alloc (&item_slab);
+      ...
+      slab_free (&item_slab, item);
+      ...
+      slab_release (&item_slab);
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct slab_chunk;
+struct slab_free;
+
+/* Slab. */
+struct slab
+  {
+    size_t obj_size;                /* Bytes per object, padded. */
+    size_t objs_per_chunk;          /* Objects carved from a chunk. */
+    struct slab_chunk *chunks;      /* All chunks, newest first. */
+    struct slab_free *free_list;    /* Freed objects. */
+    char *next;                     /* Next unused object in newest chunk. */
+    char *limit;                    /* End of newest chunk. */
+    size_t used;                    /* Objects allocated, not yet freed. */
+  };
+
+void slab_init (struct slab *, size_t obj_size, size_t objs_per_chunk);
+void *slab_alloc (struct slab *);
+void slab_free (struct slab *, void *);
+void slab_release (struct slab *);
+size_t slab_used (const struct slab *);
+
+#endif /* slab.h */
@@ -0,0 +1,160 @@
+/* Binary snapshots of integer tables.
+
+See snapshot.h for basic information. */
+
+#include "snapshot.h"
+#include <assert.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define ASSERT(CONDITION) assert(CONDITION)
+
+/* Identifies a snapshot file.  The "\r\n" and "\032" catch a
+   file mangled by newline translation or read as text. */
+static const char snapshot_magic[8] = "HSNAP\r\n\032";
+
+#define BYTE_ORDER_MARK 0x01020304u
+
+/* Snapshot file header.  All fields are naturally aligned, so the
+   layout is the one described in snapshot.h, with no padding,
+   and the values that follow start 24 bytes in.  Version 1 also
+   recorded the saved table's bucket count, which no loader
+   used. */
+struct snapshot_header
+  {
+    char magic[8];              /* snapshot_magic. */
+    uint32_t version;           /* SNAPSHOT_VERSION. */
+    uint32_t byte_order;        /* BYTE_ORDER_MARK. */
+    uint64_t value_cnt;         /* Number of values. */
+  };
+
+/* Creates FILE_NAME, replacing any existing file, and writes the
+   header of a snapshot of VALUE_CNT values.  Exactly VALUE_CNT
+   calls to snapshot_put() must follow, then one to
+   snapshot_finish().  FILE_NAME must stay valid until then.
+   Returns false if the file cannot be created. */
+bool
+snapshot_create (struct snapshot_writer *w, const char *file_name,
+                 size_t value_cnt)
+{
+  struct snapshot_header header;
+
+  ASSERT (w != NULL);
+  ASSERT (file_name != NULL);
+
+  w->file = fopen (file_name, "wb");
+  if (w->file == NULL)
+    return false;
+  w->file_name = file_name;
+  w->value_cnt = value_cnt;
+  w->put_cnt = 0;
+
+  memset (&header, 0, sizeof header);
+  memcpy (header.magic, snapshot_magic, sizeof header.magic);
+  header.version = SNAPSHOT_VERSION;
+  header.byte_order = BYTE_ORDER_MARK;
+  header.value_cnt = value_cnt;
+  fwrite (&header, sizeof header, 1, w->file);
+  return true;
+}
+
+/* Appends VALUE to the snapshot being written by W.  Errors are
+   reported by snapshot_finish(). */
+void
+snapshot_put (struct snapshot_writer *w, int value)
+{
+  int32_t v = value;
+
+  ASSERT (w != NULL);
+
+  fwrite (&v, sizeof v, 1, w->file);
+  w->put_cnt++;
+}
+
+/* Completes the snapshot being written by W and closes its file.
+   Returns true if successful.  If writing failed, or the number
+   of values put does not match the count given to
+   snapshot_create(), removes the file and returns false. */
+bool
+snapshot_finish (struct snapshot_writer *w)
+{
+  bool ok;
+
+  ASSERT (w != NULL);
+
+  ok = w->put_cnt == w->value_cnt && !ferror (w->file);
+  if (fclose (w->file) != 0)
+    ok = false;
+  w->file = NULL;
+  if (!ok)
+    remove (w->file_name);
+  return ok;
+}
+
+/* Maps snapshot file FILE_NAME into memory as SNAP, read-only,
+   and checks its header.  Returns false if the file cannot be
+   opened or mapped, or is not a snapshot written by this version
+   on a machine of the same byte order. */
+bool
+snapshot_map (struct snapshot *snap, const char *file_name)
+{
+  const struct snapshot_header *header;
+  struct stat st;
+  size_t max_cnt;
+  void *base;
+  int fd;
+
+  ASSERT (snap != NULL);
+  ASSERT (file_name != NULL);
+
+  fd = open (file_name, O_RDONLY);
+  if (fd < 0)
+    return false;
+  if (fstat (fd, &st) != 0
+      || st.st_size < (off_t) sizeof *header
+      || (uintmax_t) st.st_size > SIZE_MAX)
+    {
+      close (fd);
+      return false;
+    }
+  base = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+  if (base == MAP_FAILED)
+    return false;
+
+  header = base;
+  max_cnt = (st.st_size - sizeof *header) / sizeof (int32_t);
+  if (memcmp (header->magic, snapshot_magic, sizeof header->magic)
+      || header->version != SNAPSHOT_VERSION
+      || header->byte_order != BYTE_ORDER_MARK
+      || header->value_cnt != max_cnt
+      || (st.st_size - sizeof *header) % sizeof (int32_t) != 0)
+    {
+      munmap (base, st.st_size);
+      return false;
+    }
+
+  /* The values are read once, front to back. */
+  madvise (base, st.st_size, MADV_SEQUENTIAL);
+
+  snap->base = base;
+  snap->size = st.st_size;
+  snap->value_cnt = header->value_cnt;
+  snap->values = (const int32_t *) (header + 1);
+  return true;
+}
+
+/* Unmaps SNAP, which snapshot_map() mapped.  Pointers into its
+   values become invalid. */
+void
+snapshot_unmap (struct snapshot *snap)
+{
+  ASSERT (snap != NULL);
+
+  munmap (snap->base, snap->size);
+  snap->base = NULL;
+  snap->values = NULL;
+}
@@ -0,0 +1,76 @@
+#ifndef __MYLIB_SNAPSHOT_H
+#define __MYLIB_SNAPSHOT_H
+
+/* Binary snapshots of integer tables.
+
+   Rebuilding a big table by replaying one insertion after another
+   pays for parsing, lookups and every intermediate resize.  A
+   snapshot file instead holds a fixed header followed by the
+   table's values packed as 32-bit ints:
+
+      offset  size  field
+           0     8  magic, "HSNAP" "\r\n" "\032"
+           8     4  format version, SNAPSHOT_VERSION
+          12     4  0x01020304, to catch a byte order mismatch
+          16     8  number of values
+          24   4*n  the values
+
+   The file is written in the machine's own byte order and read
+   back with mmap(), so loading touches the values once, straight
+   from the page cache, and the loader, knowing the count up
+   front, can size its table before inserting anything.
+
+   Writing:
+
+      struct snapshot_writer w;
+
+      if (snapshot_create (&w, "table.snap", value_cnt))
+        {
+          ...snapshot_put (&w, value) for each value...
+          ok = snapshot_finish (&w);
+        }
+
+   Reading:
+
+      struct snapshot snap;
+
+      if (snapshot_map (&snap, "table.snap"))
+        {
+          ...use snap.values[0] through snap.values[snap.value_cnt - 1]...
+          snapshot_unmap (&snap);
+        } */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define SNAPSHOT_VERSION 2
+
+/* A snapshot file being written. */
+struct snapshot_writer
+  {
+    FILE *file;                 /* Output file. */
+    const char *file_name;      /* Its name, to remove on failure. */
+    size_t value_cnt;           /* Values promised in the header. */
+    size_t put_cnt;             /* Values written so far. */
+  };
+
+/* A snapshot file mapped into memory. */
+struct snapshot
+  {
+    void *base;                 /* Start of the mapping. */
+    size_t size;                /* Size of the mapping in bytes. */
+    size_t value_cnt;           /* Number of values. */
+    const int32_t *values;      /* The values, inside the mapping. */
+  };
+
+bool snapshot_create (struct snapshot_writer *, const char *file_name,
+                      size_t value_cnt);
+void snapshot_put (struct snapshot_writer *, int value);
+bool snapshot_finish (struct snapshot_writer *);
+
+bool snapshot_map (struct snapshot *, const char *file_name);
+void snapshot_unmap (struct snapshot *);
+
+#endif /* snapshot.h */